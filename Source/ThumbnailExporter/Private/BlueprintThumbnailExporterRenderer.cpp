@@ -6,7 +6,11 @@
 #include "ThumbnailExporterSettings.h"
 #include "ThumbnailExporterThumbnailDummy.h"
 #include "ThumbnailExporterScene.h"
+#include "ThumbnailExporterStats.h"
 #include "CanvasTypes.h"
+#include "Animation/AnimSequence.h"
+#include "Materials/MaterialInterface.h"
+#include "ThumbnailRendering/ThumbnailManager.h"
 #include "EngineUtils.h"
 
 #include "RendererInterface.h"
@@ -48,10 +52,15 @@ static ESimpleElementBlendMode GetMaterialBlendMode(const UMaterialInterface* Ma
 
 void UBlueprintThumbnailExporterRenderer::DrawThumbnailWithConfig(FThumbnailCreationParams& CreationParams)
 {
+	// Everything but the render itself is scene setup
+	SCOPE_THUMBNAIL_EXPORT_STAGE(SceneSetup);
+
 	bool bCanRender = false;
 	UBlueprint* Blueprint = Cast<UBlueprint>(CreationParams.Object);
 
 	FThumbnailExporterScene* ThumbnailScene = &GetThumbnailScene(CreationParams.CreationConfig);
+	ThumbnailScene->SetFraming(CreationParams.CreationConfig.FramingMode, CreationParams.CreationConfig.FramingMargin);
+	ThumbnailScene->SetMinimalSceneLights(CreationParams.CreationConfig.MinimalSceneLights, CreationParams.CreationConfig.MinimalSceneSkyBrightness);
 
 	// Strict validation - it may hopefully fix UE-35705.
 	const bool bIsBlueprintValid = IsValid(Blueprint)
@@ -62,22 +71,30 @@ void UBlueprintThumbnailExporterRenderer::DrawThumbnailWithConfig(FThumbnailCrea
 		&& !Blueprint->HasAnyFlags(RF_Transient);
 	if (bIsBlueprintValid)
 	{
-		ThumbnailScene->SetBlueprint(Blueprint);
+		// Creation delegates are written against the blueprint's actor, with its construction script run
+		const EThumbnailBlueprintSpawnMode SpawnMode = CreationParams.CreationDelegate.IsBound() ? EThumbnailBlueprintSpawnMode::FullSpawn : CreationParams.CreationConfig.BlueprintSpawnMode;
+		ThumbnailScene->SetBlueprint(Blueprint, SpawnMode);
 
 		bCanRender = true;
 	}
 
-	//UMaterialInterface* Material = Cast<UMaterialInterface>(CreationParams.Object);
-	//if (IsValid(Material))
-	//{
-	//	Material->EnsureIsComplete();
-	//	
-	//	FCanvasTileItem TileItem(FVector2D(0, 0), Material->GetRenderProxy(), CreationParams.GetThumbnailSize());
-	//	TileItem.BlendMode = GetMaterialBlendMode(Material);
-	//	TileItem.SetColor(CreationParams.CreationConfig.ThumbnailBackground);
-	//	TileItem.Draw(CreationParams.Canvas);
-	//	return;
-	//}
+	UMaterialInterface* Material = Cast<UMaterialInterface>(CreationParams.Object);
+	if (IsValid(Material))
+	{
+		if (CreationParams.CreationConfig.MaterialMode == EThumbnailMaterialMode::CanvasTile)
+		{
+			DrawMaterialTiles(CreationParams, Material);
+			return;
+		}
+
+		const bool bIsPlane = CreationParams.CreationConfig.MaterialPreviewMesh == EThumbnailMaterialPreviewMesh::Plane;
+		UStaticMesh* PreviewMesh = bIsPlane ? UThumbnailManager::Get().EditorPlane : UThumbnailManager::Get().EditorSphere;
+		if (IsValid(PreviewMesh))
+		{
+			ThumbnailScene->SetMaterial(Material, PreviewMesh, bIsPlane);
+			bCanRender = true;
+		}
+	}
 
 	UStaticMesh* StaticMesh = Cast<UStaticMesh>(CreationParams.Object);
 	if (IsValid(StaticMesh))
@@ -88,15 +105,79 @@ void UBlueprintThumbnailExporterRenderer::DrawThumbnailWithConfig(FThumbnailCrea
 		bCanRender = true;
 	}
 
+	// Flipbook poses are only sampled for skeletal meshes the animation can be played on, every other asset repeats its one pose
+	UAnimSequence* FlipbookAnimation = nullptr;
+
 	USkeletalMesh* SkeletalMesh = Cast<USkeletalMesh>(CreationParams.Object);
 	if (IsValid(SkeletalMesh))
 	{
 		ThumbnailScene->SetSkeletalMesh(SkeletalMesh);
+		FlipbookAnimation = CreationParams.CreationConfig.FlipbookAnimation.LoadSynchronous();
+		if (!ThumbnailScene->SetSkeletalMeshAnimation(FlipbookAnimation))
+		{
+			FlipbookAnimation = nullptr;
+		}
 		bCanRender = true;
 	}
 
-	if (bCanRender)
+	// Material variants are only swapped on static and skeletal meshes, every other asset repeats its one look
+	const FThumbnailCreationConfig& CreationConfig = CreationParams.CreationConfig;
+	TArray<TArray<UMaterialInterface*>> VariantMaterials;
+	if (IsValid(StaticMesh) || IsValid(SkeletalMesh))
 	{
+		for (const FThumbnailMaterialVariant& Variant : CreationConfig.MaterialVariants)
+		{
+			TArray<UMaterialInterface*>& Materials = VariantMaterials.AddDefaulted_GetRef();
+			for (const TSoftObjectPtr<UMaterialInterface>& VariantMaterial : Variant.Materials)
+			{
+				Materials.Add(VariantMaterial.LoadSynchronous());
+			}
+		}
+	}
+
+	// Each material variant and flipbook pose is its own view family, since every view in a family sees the same scene. The families render into
+	// their own frames of the same render target and are only read back once they have all been queued, so setting up the next one overlaps with rendering the last
+	const int32 NumMaterialVariants = CreationConfig.GetNumMaterialVariants();
+	const int32 NumFlipbookFrames = CreationConfig.GetNumFlipbookFrames();
+	const int32 NumTurntableAngles = CreationConfig.GetNumTurntableAngles();
+	const FIntPoint FrameGridSize = CreationConfig.GetFrameGridSize();
+	const uint32 FrameWidth = CreationParams.Width / FrameGridSize.X;
+	const uint32 FrameHeight = CreationParams.Height / FrameGridSize.Y;
+	const auto GetFramePosition = [&FrameGridSize, FrameWidth, FrameHeight](int32 Frame) { return FIntPoint((Frame % FrameGridSize.X) * FrameWidth, (Frame / FrameGridSize.X) * FrameHeight); };
+	ThumbnailScene->SetTurntable(NumTurntableAngles, CreationConfig.TurntableStartYaw, CreationConfig.bOverrideTurntablePitch ? TOptional<float>(CreationConfig.TurntablePitch) : TOptional<float>());
+
+	// Poses only differ when the asset takes the material variants or the flipbook animation. The rest look the same as an earlier pose,
+	// so only those are rendered and the caller copies their frames into the others
+	const bool bVariesByMaterial = VariantMaterials.Num() > 0;
+	const bool bVariesByFlipbookFrame = FlipbookAnimation != nullptr;
+
+	for (int32 Pose = 0; Pose < NumMaterialVariants * NumFlipbookFrames && bCanRender; ++Pose)
+	{
+		const int32 MaterialVariant = Pose / NumFlipbookFrames;
+		const int32 FlipbookFrame = Pose % NumFlipbookFrames;
+
+		const int32 SourcePose = (bVariesByMaterial ? MaterialVariant : 0) * NumFlipbookFrames + (bVariesByFlipbookFrame ? FlipbookFrame : 0);
+		if (SourcePose != Pose)
+		{
+			for (int32 TurntableAngle = 0; TurntableAngle < NumTurntableAngles; ++TurntableAngle)
+			{
+				const FIntPoint SourcePosition = GetFramePosition(SourcePose * NumTurntableAngles + TurntableAngle);
+				const FIntPoint DestPosition = GetFramePosition(Pose * NumTurntableAngles + TurntableAngle);
+				CreationParams.FrameCopies.Add({ SourcePosition, DestPosition, FIntPoint(FrameWidth, FrameHeight) });
+			}
+			continue;
+		}
+
+		if (FlipbookFrame == 0 && VariantMaterials.IsValidIndex(MaterialVariant))
+		{
+			ThumbnailScene->SetOverrideMaterials(VariantMaterials[MaterialVariant]);
+		}
+
+		if (FlipbookAnimation)
+		{
+			ThumbnailScene->SetSkeletalMeshAnimationTime(FlipbookAnimation->GetPlayLength() * FlipbookFrame / NumFlipbookFrames);
+		}
+
 		FSceneViewFamilyContext ViewFamily(FSceneViewFamily::ConstructionValues(CreationParams.RenderTarget, ThumbnailScene->GetScene(), FEngineShowFlags(ESFIM_Game))
 			.SetTime(UThumbnailRenderer::GetTime())
 			.SetDeferClear(true)
@@ -158,28 +239,61 @@ void UBlueprintThumbnailExporterRenderer::DrawThumbnailWithConfig(FThumbnailCrea
 			ViewFamily.SceneCaptureCompositeMode = ESceneCaptureCompositeMode::SCCM_Overwrite;
 		}
 
-		FSceneView* View = ThumbnailScene->CreateView(&ViewFamily, 0, 0, CreationParams.Width, CreationParams.Height);
-		View->BackgroundColor = CreationParams.CreationConfig.GetAdjustedBackgroundColor();
+		// Every turntable angle of a pose is its own view in the same view family, so the scene is set up and rendered once for all of them
+		FSceneView* View = nullptr;
+		for (int32 TurntableAngle = 0; TurntableAngle < NumTurntableAngles; ++TurntableAngle)
+		{
+			ThumbnailScene->SetTurntableAngle(TurntableAngle);
 
-		if (CreationParams.CreationDelegate.IsBound())
+			const FIntPoint FramePosition = GetFramePosition(Pose * NumTurntableAngles + TurntableAngle);
+			FSceneView* FrameView = ThumbnailScene->CreateView(&ViewFamily, FramePosition.X, FramePosition.Y, FrameWidth, FrameHeight);
+			FrameView->BackgroundColor = CreationConfig.GetAdjustedBackgroundColor();
+			if (View == nullptr)
+			{
+				View = FrameView;
+			}
+		}
+
+		if (Pose == 0 && CreationParams.CreationDelegate.IsBound())
 		{
 			CreationParams.CreationConfig = CreationParams.CreationDelegate.Execute(CreationParams.CreationConfig, ThumbnailScene->GetPreviewActor().Get());
 		}
 
-		RenderViewFamily(CreationParams.Canvas, &ViewFamily, View);
+		// Every frame shares the same framing, so the LODs picked for the first view hold for all of them
+		if (Pose == 0)
+		{
+			CreationParams.NumTriangles = ThumbnailScene->ApplyLODPolicy(CreationConfig, *View, FrameHeight);
+
+			// The alpha pass renders the same scene, its textures are already streamed in
+			if (!CreationParams.bIsAlpha)
+			{
+				ThumbnailScene->StreamTextures(*View);
+			}
+		}
+
+		if (CreationParams.bIsAlpha)
+		{
+			SCOPE_THUMBNAIL_EXPORT_STAGE(RenderAlpha);
+			RenderViewFamily(CreationParams.Canvas, &ViewFamily, View);
+		}
+		else
+		{
+			SCOPE_THUMBNAIL_EXPORT_STAGE(RenderColor);
+			RenderViewFamily(CreationParams.Canvas, &ViewFamily, View);
+		}
+	}
 
-		// If we used a creation delegate, then delete the scene.
-		// The scene can be messed up by the creation delegate, so its better to just recreate it
-		if (CreationParams.CreationDelegate.IsBound())
+	// If we used a creation delegate, then delete the scene.
+	// The scene can be messed up by the creation delegate, so its better to just recreate it
+	if (bCanRender && CreationParams.CreationDelegate.IsBound())
+	{
+		for (FThumbnailExporterScene* DestroyThumbnailScene : ThumbnailScenes)
 		{
-			for (FThumbnailExporterScene* DestroyThumbnailScene : ThumbnailScenes)
+			if (DestroyThumbnailScene == ThumbnailScene)
 			{
-				if (DestroyThumbnailScene == ThumbnailScene)
-				{
-					delete DestroyThumbnailScene;
-					ThumbnailScenes.Remove(ThumbnailScene);
-					break;
-				}
+				delete DestroyThumbnailScene;
+				ThumbnailScenes.Remove(ThumbnailScene);
+				break;
 			}
 		}
 	}
@@ -202,14 +316,40 @@ bool UBlueprintThumbnailExporterRenderer::CanVisualizeAsset(UObject* Object)
 		return true;
 	}
 
-	//if (Cast<UMaterialInterface>(Object))
-	//{
-	//	return true;
-	//}
+	if (Cast<UMaterialInterface>(Object))
+	{
+		return true;
+	}
 
 	return Super::CanVisualizeAsset(Object);
 }
 
+void UBlueprintThumbnailExporterRenderer::DrawMaterialTiles(FThumbnailCreationParams& CreationParams, UMaterialInterface* Material)
+{
+	const FIntPoint FrameGridSize = CreationParams.CreationConfig.GetFrameGridSize();
+	const FVector2D FrameSize(CreationParams.Width / FrameGridSize.X, CreationParams.Height / FrameGridSize.Y);
+
+	// Every frame of a sprite sheet gets the same tile, so material thumbnails have the same layout as the rest of the batch
+	for (int32 Frame = 0; Frame < CreationParams.CreationConfig.GetNumFrames(); ++Frame)
+	{
+		const FVector2D FramePosition((Frame % FrameGridSize.X) * FrameSize.X, (Frame / FrameGridSize.X) * FrameSize.Y);
+
+		if (CreationParams.bIsAlpha)
+		{
+			// The alpha target stores inverted opacity, so clearing the tile to zero makes it opaque
+			FCanvasTileItem TileItem(FramePosition, FrameSize, FLinearColor::Transparent);
+			TileItem.BlendMode = ESimpleElementBlendMode::SE_BLEND_Opaque;
+			TileItem.Draw(CreationParams.Canvas);
+		}
+		else
+		{
+			FCanvasTileItem TileItem(FramePosition, Material->GetRenderProxy(), FrameSize);
+			TileItem.BlendMode = GetMaterialBlendMode(Material);
+			TileItem.Draw(CreationParams.Canvas);
+		}
+	}
+}
+
 void UBlueprintThumbnailExporterRenderer::BeginDestroy()
 {
 	for (FThumbnailExporterScene* ThumbnailScene : ThumbnailScenes)
@@ -228,7 +368,7 @@ void UBlueprintThumbnailExporterRenderer::RenderViewFamily(FCanvas* Canvas, FSce
 		return;
 	}
 
-	check(ViewFamily->Views.Num() == 1 && (ViewFamily->Views[0] == View));
+	check(ViewFamily->Views.Num() > 0 && (ViewFamily->Views[0] == View));
 
 	ViewFamily->EngineShowFlags.ScreenPercentage = false;
 	ViewFamily->bThumbnailRendering = true;
@@ -243,13 +383,14 @@ void UBlueprintThumbnailExporterRenderer::RenderViewFamily(FCanvas* Canvas, FSce
 
 FThumbnailExporterScene& UBlueprintThumbnailExporterRenderer::GetThumbnailScene(const FThumbnailCreationConfig& CreationConfig)
 {
+	const FThumbnailExporterSceneKey SceneKey(CreationConfig);
 	for (FThumbnailExporterScene* ThumbnailScene : ThumbnailScenes)
 	{
-		if (ThumbnailScene->GetBackgroundMeshesHidden() == CreationConfig.bHideThumbnailBackgroundMeshes)
+		if (ThumbnailScene->GetSceneKey() == SceneKey)
 		{
 			return *ThumbnailScene;
 		}
 	}
 
-	return *ThumbnailScenes.Add_GetRef(new FThumbnailExporterScene(CreationConfig.bHideThumbnailBackgroundMeshes));
+	return *ThumbnailScenes.Add_GetRef(new FThumbnailExporterScene(SceneKey));
 }
\ No newline at end of file
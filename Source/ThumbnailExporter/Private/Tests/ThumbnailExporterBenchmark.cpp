@@ -0,0 +1,480 @@
+// Copyright 2023 Big Cat Energising. All Rights Reserved.
+
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "ThumbnailExporter.h"
+#include "ThumbnailExporterSettings.h"
+#include "ThumbnailExporterRenderer.h"
+#include "AssetRegistry/AssetData.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/Blueprint.h"
+#include "Engine/BlueprintGeneratedClass.h"
+#include "Engine/SimpleConstructionScript.h"
+#include "Engine/SCS_Node.h"
+#include "Components/StaticMeshComponent.h"
+#include "Materials/Material.h"
+#include "Kismet2/KismetEditorUtilities.h"
+#include "MeshDescription.h"
+#include "StaticMeshAttributes.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/FileHelper.h"
+#include "Math/RandomStream.h"
+#include "Misc/Guid.h"
+#include "UObject/UObjectHash.h"
+#include "UObject/UObjectIterator.h"
+
+namespace ThumbnailExporterBenchmark
+{
+	// Generated assets and exported thumbnails go in a folder per case under here, so nothing ends up in the project's content
+	// and cases don't overwrite each other's assets
+	static const TCHAR* BenchmarkPackagePath = TEXT("/Temp/ThumbnailExporterBenchmark");
+
+	// Skeletal meshes can't be built from scratch without an import, so the benchmark duplicates an engine mesh
+	static const TCHAR* SkeletalMeshTemplatePaths[] = {
+		TEXT("/Engine/EditorMeshes/SkeletalMesh/DefaultSkeletalMesh.DefaultSkeletalMesh"),
+		TEXT("/Engine/EngineMeshes/SkeletalCube.SkeletalCube")
+	};
+
+	// Throughput drops below this fraction of the baseline are reported as warnings
+	static const double RegressionThreshold = 0.8;
+
+	static const TCHAR* AssetKinds[] = { TEXT("StaticMesh"), TEXT("SkeletalMesh"), TEXT("Blueprint") };
+
+	// Every case runs in both the asset thumbnail preview scene and the minimal scene, so the two can be compared
+	static const TCHAR* SceneKinds[] = { TEXT("PreviewScene"), TEXT("MinimalScene") };
+
+	struct FBenchmarkResult
+	{
+		int32 NumAssets = 0;
+		int32 ThumbnailSize = 0;
+		bool bNullRHI = false;
+		double ThumbnailsPerSecond = 0.0;
+		double P50Milliseconds = 0.0;
+		double P99Milliseconds = 0.0;
+		double PeakMemoryMB = 0.0;
+
+		TSharedRef<FJsonObject> ToJson() const
+		{
+			TSharedRef<FJsonObject> Json = MakeShared<FJsonObject>();
+			Json->SetNumberField(TEXT("NumAssets"), NumAssets);
+			Json->SetNumberField(TEXT("ThumbnailSize"), ThumbnailSize);
+			Json->SetBoolField(TEXT("NullRHI"), bNullRHI);
+			Json->SetNumberField(TEXT("ThumbnailsPerSecond"), ThumbnailsPerSecond);
+			Json->SetNumberField(TEXT("P50Milliseconds"), P50Milliseconds);
+			Json->SetNumberField(TEXT("P99Milliseconds"), P99Milliseconds);
+			Json->SetNumberField(TEXT("PeakMemoryMB"), PeakMemoryMB);
+			return Json;
+		}
+	};
+
+	static int32 GetNumBenchmarkAssets()
+	{
+		int32 NumAssets = 32;
+		FParse::Value(FCommandLine::Get(), TEXT("ThumbnailExporterBenchmarkAssets="), NumAssets);
+		return FMath::Max(NumAssets, 1);
+	}
+
+	static FString GetBenchmarkDirectory()
+	{
+		return FPaths::ProjectSavedDir() / TEXT("ThumbnailExporter") / TEXT("Benchmarks");
+	}
+
+	static UPackage* CreateBenchmarkPackage(const FString& CasePath, const FString& Folder, const FString& Name)
+	{
+		UPackage* Package = CreatePackage(*(CasePath / Folder / Name));
+		Package->FullyLoad();
+		return Package;
+	}
+
+	// Builds a box with the given half size. Boxes of different proportions cover both compact and elongated assets
+	static UStaticMesh* CreateBoxMesh(const FString& CasePath, const FString& Name, const FVector3f& Extent)
+	{
+		UPackage* Package = CreateBenchmarkPackage(CasePath, TEXT("StaticMeshes"), Name);
+
+		FMeshDescription MeshDescription;
+		FStaticMeshAttributes Attributes(MeshDescription);
+		Attributes.Register();
+
+		const FPolygonGroupID PolygonGroup = MeshDescription.CreatePolygonGroup();
+		Attributes.GetPolygonGroupMaterialSlotNames()[PolygonGroup] = TEXT("Default");
+
+		// Corner i is at -Extent/+Extent on X, Y and Z depending on bits 0, 1 and 2 of i
+		FVertexID Vertices[8];
+		for (int32 i = 0; i < 8; ++i)
+		{
+			Vertices[i] = MeshDescription.CreateVertex();
+			Attributes.GetVertexPositions()[Vertices[i]] = FVector3f(
+				(i & 1) ? Extent.X : -Extent.X,
+				(i & 2) ? Extent.Y : -Extent.Y,
+				(i & 4) ? Extent.Z : -Extent.Z);
+		}
+
+		// Corners of each face, wound so the faces point outwards
+		static const int32 FaceCorners[6][4] = {
+			{ 0, 2, 6, 4 }, { 1, 5, 7, 3 },
+			{ 0, 4, 5, 1 }, { 2, 3, 7, 6 },
+			{ 0, 1, 3, 2 }, { 4, 6, 7, 5 }
+		};
+		static const FVector3f FaceNormals[6] = {
+			FVector3f(-1, 0, 0), FVector3f(1, 0, 0),
+			FVector3f(0, -1, 0), FVector3f(0, 1, 0),
+			FVector3f(0, 0, -1), FVector3f(0, 0, 1)
+		};
+		static const FVector2f CornerUVs[4] = { FVector2f(0, 0), FVector2f(1, 0), FVector2f(1, 1), FVector2f(0, 1) };
+
+		for (int32 Face = 0; Face < 6; ++Face)
+		{
+			TArray<FVertexInstanceID> VertexInstances;
+			for (int32 Corner = 0; Corner < 4; ++Corner)
+			{
+				const FVertexInstanceID VertexInstance = MeshDescription.CreateVertexInstance(Vertices[FaceCorners[Face][Corner]]);
+				Attributes.GetVertexInstanceNormals()[VertexInstance] = FaceNormals[Face];
+				Attributes.GetVertexInstanceUVs().Set(VertexInstance, 0, CornerUVs[Corner]);
+				VertexInstances.Add(VertexInstance);
+			}
+			MeshDescription.CreatePolygon(PolygonGroup, VertexInstances);
+		}
+
+		UStaticMesh* StaticMesh = NewObject<UStaticMesh>(Package, *Name, RF_Public | RF_Standalone);
+		StaticMesh->GetStaticMaterials().Add(FStaticMaterial(UMaterial::GetDefaultMaterial(MD_Surface), TEXT("Default")));
+
+		UStaticMesh::FBuildMeshDescriptionsParams BuildParams;
+		BuildParams.bBuildSimpleCollision = false;
+		StaticMesh->BuildFromMeshDescriptions({ &MeshDescription }, BuildParams);
+
+		return StaticMesh;
+	}
+
+	static FVector3f GetRandomExtent(FRandomStream& Random)
+	{
+		return FVector3f(Random.FRandRange(5.f, 200.f), Random.FRandRange(5.f, 200.f), Random.FRandRange(5.f, 200.f));
+	}
+
+	static TArray<UObject*> CreateStaticMeshes(const FString& CasePath, int32 NumAssets, FRandomStream& Random)
+	{
+		TArray<UObject*> Assets;
+		for (int32 i = 0; i < NumAssets; ++i)
+		{
+			Assets.Add(CreateBoxMesh(CasePath, FString::Printf(TEXT("SM_Benchmark_%d"), i), GetRandomExtent(Random)));
+		}
+		return Assets;
+	}
+
+	static TArray<UObject*> CreateSkeletalMeshes(const FString& CasePath, int32 NumAssets)
+	{
+		USkeletalMesh* Template = nullptr;
+		for (const TCHAR* TemplatePath : SkeletalMeshTemplatePaths)
+		{
+			Template = LoadObject<USkeletalMesh>(nullptr, TemplatePath, nullptr, LOAD_NoWarn);
+			if (Template)
+			{
+				break;
+			}
+		}
+
+		TArray<UObject*> Assets;
+		if (Template == nullptr)
+		{
+			return Assets;
+		}
+
+		for (int32 i = 0; i < NumAssets; ++i)
+		{
+			const FString Name = FString::Printf(TEXT("SK_Benchmark_%d"), i);
+			UPackage* Package = CreateBenchmarkPackage(CasePath, TEXT("SkeletalMeshes"), Name);
+			USkeletalMesh* SkeletalMesh = DuplicateObject<USkeletalMesh>(Template, Package, *Name);
+			SkeletalMesh->SetFlags(RF_Public | RF_Standalone);
+			Assets.Add(SkeletalMesh);
+		}
+		return Assets;
+	}
+
+	// Actor blueprints made of a few box mesh components at random offsets
+	static TArray<UObject*> CreateBlueprints(const FString& CasePath, int32 NumAssets, FRandomStream& Random)
+	{
+		TArray<UStaticMesh*> ComponentMeshes;
+		for (int32 i = 0; i < 4; ++i)
+		{
+			ComponentMeshes.Add(CreateBoxMesh(CasePath, FString::Printf(TEXT("SM_BenchmarkComponent_%d"), i), GetRandomExtent(Random)));
+		}
+
+		TArray<UObject*> Assets;
+		for (int32 i = 0; i < NumAssets; ++i)
+		{
+			const FString Name = FString::Printf(TEXT("BP_Benchmark_%d"), i);
+			UPackage* Package = CreateBenchmarkPackage(CasePath, TEXT("Blueprints"), Name);
+			UBlueprint* Blueprint = FKismetEditorUtilities::CreateBlueprint(AActor::StaticClass(), Package, *Name, BPTYPE_Normal, UBlueprint::StaticClass(), UBlueprintGeneratedClass::StaticClass());
+
+			const int32 NumComponents = Random.RandRange(1, 4);
+			for (int32 ComponentIndex = 0; ComponentIndex < NumComponents; ++ComponentIndex)
+			{
+				USCS_Node* Node = Blueprint->SimpleConstructionScript->CreateNode(UStaticMeshComponent::StaticClass(), *FString::Printf(TEXT("Mesh%d"), ComponentIndex));
+				UStaticMeshComponent* ComponentTemplate = CastChecked<UStaticMeshComponent>(Node->ComponentTemplate);
+				ComponentTemplate->SetStaticMesh(ComponentMeshes[Random.RandHelper(ComponentMeshes.Num())]);
+				if (ComponentIndex > 0)
+				{
+					ComponentTemplate->SetRelativeLocation(FVector(Random.FRandRange(-200.f, 200.f), Random.FRandRange(-200.f, 200.f), Random.FRandRange(-200.f, 200.f)));
+				}
+				Blueprint->SimpleConstructionScript->AddNode(Node);
+			}
+
+			FKismetEditorUtilities::CompileBlueprint(Blueprint);
+			Assets.Add(Blueprint);
+		}
+		return Assets;
+	}
+
+	// Unique per run as well, so a case never picks up packages a previous run left in memory
+	static FString GetCasePath(const FString& Parameters)
+	{
+		const FString CaseName = Parameters.Replace(TEXT(" "), TEXT("_"));
+		return FString(BenchmarkPackagePath) / FString::Printf(TEXT("%s_%s"), *CaseName, *FGuid::NewGuid().ToString());
+	}
+
+	// Deletes every package of the case, generated assets, their component meshes and the exported thumbnails alike, from memory and disk
+	static void DestroyBenchmarkPackages(const FString& CasePath)
+	{
+		const FString CasePathPrefix = CasePath / TEXT("");
+
+		TArray<UPackage*> Packages;
+		for (TObjectIterator<UPackage> It; It; ++It)
+		{
+			if (It->GetName().StartsWith(CasePathPrefix))
+			{
+				Packages.Add(*It);
+			}
+		}
+
+		for (UPackage* Package : Packages)
+		{
+			ForEachObjectWithPackage(Package, [](UObject* Object)
+			{
+				Object->ClearFlags(RF_Public | RF_Standalone);
+				Object->MarkAsGarbage();
+				return true;
+			});
+			Package->SetDirtyFlag(false);
+			Package->MarkAsGarbage();
+		}
+
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+
+		IFileManager::Get().DeleteDirectory(*FPackageName::LongPackageNameToFilename(CasePathPrefix), false, true);
+	}
+
+	static double GetPercentile(const TArray<double>& SortedValues, double Percentile)
+	{
+		const int32 Index = FMath::Clamp(FMath::CeilToInt(Percentile * SortedValues.Num()) - 1, 0, SortedValues.Num() - 1);
+		return SortedValues[Index];
+	}
+
+	static TSharedPtr<FJsonObject> LoadResults(const FString& Filename)
+	{
+		FString JsonString;
+		TSharedPtr<FJsonObject> Json;
+		if (FFileHelper::LoadFileToString(JsonString, *Filename))
+		{
+			FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(JsonString), Json);
+		}
+		return Json.IsValid() ? Json : MakeShared<FJsonObject>();
+	}
+
+	static void SaveResults(const FString& Filename, const TSharedRef<FJsonObject>& Json)
+	{
+		FString JsonString;
+		FJsonSerializer::Serialize(Json, TJsonWriterFactory<>::Create(&JsonString));
+		FFileHelper::SaveStringToFile(JsonString, *Filename);
+	}
+}
+
+/**
+ * Exports procedurally generated static meshes, skeletal meshes and blueprints with each thumbnail creation preset,
+ * and measures the throughput, latency and memory use of the export. Runs under -nullrhi too, which leaves only the CPU side stages.
+ *
+ * Every case is run in the preview scene and in the minimal scene. The minimal scene run also reports its speedup over the preview scene run.
+ * The results are written to Saved/ThumbnailExporter/Benchmarks/Latest.json and compared against Baseline.json.
+ * Pass -ThumbnailExporterUpdateBaseline to replace the baseline, and -ThumbnailExporterBenchmarkAssets=N to change the number of assets
+ */
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FThumbnailExporterBenchmarkTest, "ThumbnailExporter.Benchmark", EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+void FThumbnailExporterBenchmarkTest::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+	const TArray<FThumbnailCreationPreset>& Presets = UThumbnailExporterSettings::Get()->ThumbnailCreationPresets;
+	for (int32 PresetIndex = 0; PresetIndex < Presets.Num(); ++PresetIndex)
+	{
+		// Dots would split the preset name into separate levels of the test tree
+		const FString PresetName = Presets[PresetIndex].MenuItemName.ToString().Replace(TEXT("."), TEXT("_"));
+
+		for (const TCHAR* AssetKind : ThumbnailExporterBenchmark::AssetKinds)
+		{
+			for (const TCHAR* SceneKind : ThumbnailExporterBenchmark::SceneKinds)
+			{
+				OutBeautifiedNames.Add(FString::Printf(TEXT("%s.%s.%s"), *PresetName, AssetKind, SceneKind));
+				OutTestCommands.Add(FString::Printf(TEXT("%d %s %s"), PresetIndex, AssetKind, SceneKind));
+			}
+		}
+	}
+}
+
+bool FThumbnailExporterBenchmarkTest::RunTest(const FString& Parameters)
+{
+	using namespace ThumbnailExporterBenchmark;
+
+	TArray<FString> ParameterList;
+	if (Parameters.ParseIntoArray(ParameterList, TEXT(" ")) != 3)
+	{
+		AddError(FString::Printf(TEXT("Invalid benchmark parameters: %s"), *Parameters));
+		return false;
+	}
+	const FString& PresetIndexString = ParameterList[0];
+	const FString& AssetKind = ParameterList[1];
+	const bool bMinimalScene = ParameterList[2] == TEXT("MinimalScene");
+
+	const TArray<FThumbnailCreationPreset>& Presets = UThumbnailExporterSettings::Get()->ThumbnailCreationPresets;
+	const int32 PresetIndex = FCString::Atoi(*PresetIndexString);
+	if (!Presets.IsValidIndex(PresetIndex))
+	{
+		AddError(FString::Printf(TEXT("Thumbnail creation preset %d no longer exists"), PresetIndex));
+		return false;
+	}
+
+	// Export every thumbnail in full, into the case's temp folder
+	const FString CasePath = GetCasePath(Parameters);
+	FThumbnailCreationConfig CreationConfig = Presets[PresetIndex].PresetConfig;
+	CreationConfig.bOverrideThumbnailPath = true;
+	CreationConfig.ThumbnailOverridePath.Path = CasePath / TEXT("Thumbnails");
+	CreationConfig.bCreateThumbnailNotification = false;
+	CreationConfig.bSkipUnchangedThumbnails = false;
+	CreationConfig.bWriteTimingReport = false;
+	CreationConfig.bUseMinimalScene = bMinimalScene;
+
+	const int32 NumAssets = GetNumBenchmarkAssets();
+	FRandomStream Random(PresetIndex);
+
+	TArray<UObject*> Assets;
+	if (AssetKind == TEXT("StaticMesh"))
+	{
+		Assets = CreateStaticMeshes(CasePath, NumAssets, Random);
+	}
+	else if (AssetKind == TEXT("SkeletalMesh"))
+	{
+		Assets = CreateSkeletalMeshes(CasePath, NumAssets);
+		if (Assets.Num() == 0)
+		{
+			AddWarning(TEXT("No engine skeletal mesh to duplicate was found, skipping the skeletal mesh benchmark"));
+			return true;
+		}
+	}
+	else if (AssetKind == TEXT("Blueprint"))
+	{
+		Assets = CreateBlueprints(CasePath, NumAssets, Random);
+	}
+
+	if (Assets.Num() == 0)
+	{
+		DestroyBenchmarkPackages(CasePath);
+		AddError(FString::Printf(TEXT("Failed to create %s assets for the benchmark"), *AssetKind));
+		return false;
+	}
+
+	// Null RHI runs only measure the CPU side of the export, with thumbnails filled with the background color
+	TGuardValue<bool> FillWithoutRenderer(FThumbnailExporterRenderer::bFillThumbnailsWithoutRenderer, true);
+
+	// Export one thumbnail first so one time costs (scene creation, shader compilation) don't end up in the measurements
+	FString ThumbnailPath;
+	FThumbnailExporterModule::ExportThumbnail(CreationConfig, FAssetData(Assets[0]), ThumbnailPath);
+
+	const uint64 StartUsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+	uint64 PeakUsedPhysical = StartUsedPhysical;
+	int32 NumFailed = 0;
+
+	TArray<double> Latencies;
+	const double StartTime = FPlatformTime::Seconds();
+	for (UObject* Asset : Assets)
+	{
+		const double ExportStartTime = FPlatformTime::Seconds();
+		if (!FThumbnailExporterModule::ExportThumbnail(CreationConfig, FAssetData(Asset), ThumbnailPath))
+		{
+			NumFailed++;
+		}
+		Latencies.Add(FPlatformTime::Seconds() - ExportStartTime);
+
+		PeakUsedPhysical = FMath::Max<uint64>(PeakUsedPhysical, FPlatformMemory::GetStats().UsedPhysical);
+	}
+	const double TotalSeconds = FPlatformTime::Seconds() - StartTime;
+
+	Latencies.Sort();
+
+	FBenchmarkResult Result;
+	Result.NumAssets = Assets.Num();
+	Result.ThumbnailSize = CreationConfig.ThumbnailSize;
+	Result.bNullRHI = !FApp::CanEverRender();
+	Result.ThumbnailsPerSecond = TotalSeconds > 0.0 ? Assets.Num() / TotalSeconds : 0.0;
+	Result.P50Milliseconds = GetPercentile(Latencies, 0.5) * 1000.0;
+	Result.P99Milliseconds = GetPercentile(Latencies, 0.99) * 1000.0;
+	Result.PeakMemoryMB = (PeakUsedPhysical - StartUsedPhysical) / (1024.0 * 1024.0);
+
+	DestroyBenchmarkPackages(CasePath);
+
+	AddInfo(FString::Printf(TEXT("%s: %d assets at %dpx, %.2f thumbnails/s, p50 %.1f ms, p99 %.1f ms, peak memory +%.1f MB%s"),
+		*Parameters, Result.NumAssets, Result.ThumbnailSize, Result.ThumbnailsPerSecond, Result.P50Milliseconds, Result.P99Milliseconds, Result.PeakMemoryMB,
+		Result.bNullRHI ? TEXT(" (null RHI)") : TEXT("")));
+
+	if (NumFailed > 0)
+	{
+		AddError(FString::Printf(TEXT("%d of %d thumbnails failed to export"), NumFailed, Assets.Num()));
+	}
+
+	// Results are keyed by test, scene and RHI, null RHI runs aren't comparable with rendering runs
+	const FString NullRHIKey = Result.bNullRHI ? TEXT(" NullRHI") : TEXT("");
+	const FString PreviewSceneResultKey = FString::Printf(TEXT("%s %s%s"), *Presets[PresetIndex].MenuItemName.ToString(), *AssetKind, *NullRHIKey);
+	const FString ResultKey = bMinimalScene ? FString::Printf(TEXT("%s %s MinimalScene%s"), *Presets[PresetIndex].MenuItemName.ToString(), *AssetKind, *NullRHIKey) : PreviewSceneResultKey;
+	const FString BenchmarkDirectory = GetBenchmarkDirectory();
+	IFileManager::Get().MakeDirectory(*BenchmarkDirectory, true);
+
+	const FString LatestFilename = BenchmarkDirectory / TEXT("Latest.json");
+	TSharedPtr<FJsonObject> LatestResults = LoadResults(LatestFilename);
+	LatestResults->SetObjectField(ResultKey, Result.ToJson());
+	SaveResults(LatestFilename, LatestResults.ToSharedRef());
+
+	const TSharedPtr<FJsonObject>* PreviewSceneResult = nullptr;
+	if (bMinimalScene && LatestResults->TryGetObjectField(PreviewSceneResultKey, PreviewSceneResult))
+	{
+		const double PreviewSceneThumbnailsPerSecond = (*PreviewSceneResult)->GetNumberField(TEXT("ThumbnailsPerSecond"));
+		AddInfo(FString::Printf(TEXT("Preview scene: %.2f thumbnails/s, p50 %.1f ms, p99 %.1f ms. Minimal scene speedup: %.2fx"),
+			PreviewSceneThumbnailsPerSecond, (*PreviewSceneResult)->GetNumberField(TEXT("P50Milliseconds")), (*PreviewSceneResult)->GetNumberField(TEXT("P99Milliseconds")),
+			PreviewSceneThumbnailsPerSecond > 0.0 ? Result.ThumbnailsPerSecond / PreviewSceneThumbnailsPerSecond : 0.0));
+	}
+
+	const FString BaselineFilename = BenchmarkDirectory / TEXT("Baseline.json");
+	TSharedPtr<FJsonObject> BaselineResults = LoadResults(BaselineFilename);
+	const TSharedPtr<FJsonObject>* Baseline = nullptr;
+	if (!FParse::Param(FCommandLine::Get(), TEXT("ThumbnailExporterUpdateBaseline")) && BaselineResults->TryGetObjectField(ResultKey, Baseline))
+	{
+		const double BaselineThumbnailsPerSecond = (*Baseline)->GetNumberField(TEXT("ThumbnailsPerSecond"));
+		AddInfo(FString::Printf(TEXT("Baseline: %.2f thumbnails/s, p50 %.1f ms, p99 %.1f ms, peak memory +%.1f MB"),
+			BaselineThumbnailsPerSecond, (*Baseline)->GetNumberField(TEXT("P50Milliseconds")), (*Baseline)->GetNumberField(TEXT("P99Milliseconds")), (*Baseline)->GetNumberField(TEXT("PeakMemoryMB"))));
+
+		if (Result.ThumbnailsPerSecond < BaselineThumbnailsPerSecond * RegressionThreshold)
+		{
+			AddWarning(FString::Printf(TEXT("Throughput regressed from %.2f to %.2f thumbnails/s"), BaselineThumbnailsPerSecond, Result.ThumbnailsPerSecond));
+		}
+	}
+	else
+	{
+		BaselineResults->SetObjectField(ResultKey, Result.ToJson());
+		SaveResults(BaselineFilename, BaselineResults.ToSharedRef());
+	}
+
+	return NumFailed == 0;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,130 @@
+// Copyright 2023 Big Cat Energising. All Rights Reserved.
+
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "ThumbnailExporterSettings.h"
+#include "ThumbnailExporterRenderer.h"
+#include "BlueprintThumbnailExporterRenderer.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/Blueprint.h"
+#include "Engine/BlueprintGeneratedClass.h"
+#include "Engine/SimpleConstructionScript.h"
+#include "Engine/SCS_Node.h"
+#include "Components/StaticMeshComponent.h"
+#include "Kismet2/KismetEditorUtilities.h"
+#include "Misc/ObjectThumbnail.h"
+
+namespace ThumbnailExporterFrameCopyTest
+{
+	// Returns true if any pixel of the frame isn't fully transparent
+	static bool IsFrameCovered(const TArray<uint8>& ImageData, int32 ImageWidth, FIntPoint FramePosition, FIntPoint FrameSize)
+	{
+		const FColor* Pixels = (const FColor*)ImageData.GetData();
+		for (int32 Y = FramePosition.Y; Y < FramePosition.Y + FrameSize.Y; ++Y)
+		{
+			for (int32 X = FramePosition.X; X < FramePosition.X + FrameSize.X; ++X)
+			{
+				if (Pixels[Y * ImageWidth + X].A > 0)
+				{
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	static bool AreFramesEqual(const TArray<uint8>& ImageData, int32 ImageWidth, FIntPoint FramePosition, FIntPoint OtherFramePosition, FIntPoint FrameSize)
+	{
+		const FColor* Pixels = (const FColor*)ImageData.GetData();
+		for (int32 Row = 0; Row < FrameSize.Y; ++Row)
+		{
+			const FColor* FrameRow = Pixels + (FramePosition.Y + Row) * ImageWidth + FramePosition.X;
+			const FColor* OtherFrameRow = Pixels + (OtherFramePosition.Y + Row) * ImageWidth + OtherFramePosition.X;
+			if (FMemory::Memcmp(FrameRow, OtherFrameRow, FrameSize.X * sizeof(FColor)) != 0)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FThumbnailExporterCopyFramesTest, "ThumbnailExporter.FrameCopy.CopyFrames", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FThumbnailExporterCopyFramesTest::RunTest(const FString& Parameters)
+{
+	using namespace ThumbnailExporterFrameCopyTest;
+
+	// Two 2x2 frames side by side, only the first one drawn
+	const int32 ImageWidth = 4;
+	TArray<uint8> ImageData;
+	ImageData.SetNumZeroed(ImageWidth * 2 * sizeof(FColor));
+	FColor* Pixels = (FColor*)ImageData.GetData();
+	for (int32 Y = 0; Y < 2; ++Y)
+	{
+		for (int32 X = 0; X < 2; ++X)
+		{
+			Pixels[Y * ImageWidth + X] = FColor(255, Y * 2 + X, 0, 255);
+		}
+	}
+
+	FThumbnailExporterRenderer::CopyFrames(ImageData, ImageWidth, { { FIntPoint(0, 0), FIntPoint(2, 0), FIntPoint(2, 2) } });
+
+	TestTrue(TEXT("The copied frame is drawn"), IsFrameCovered(ImageData, ImageWidth, FIntPoint(2, 0), FIntPoint(2, 2)));
+	TestTrue(TEXT("The copied frame matches its source"), AreFramesEqual(ImageData, ImageWidth, FIntPoint(0, 0), FIntPoint(2, 0), FIntPoint(2, 2)));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FThumbnailExporterRepeatedPoseTest, "ThumbnailExporter.FrameCopy.RepeatedPose", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FThumbnailExporterRepeatedPoseTest::RunTest(const FString& Parameters)
+{
+	using namespace ThumbnailExporterFrameCopyTest;
+
+	if (!FApp::CanEverRender())
+	{
+		AddInfo(TEXT("Skipped, there is no renderer"));
+		return true;
+	}
+
+	UStaticMesh* Cube = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+	if (!TestNotNull(TEXT("Engine cube mesh"), Cube))
+	{
+		return false;
+	}
+
+	// Blueprints don't take material variants, so the second variant is a repeat of the first pose and is copied instead of rendered
+	UPackage* Package = CreatePackage(TEXT("/Temp/ThumbnailExporterFrameCopyTest/BP_RepeatedPose"));
+	UBlueprint* Blueprint = FKismetEditorUtilities::CreateBlueprint(AActor::StaticClass(), Package, TEXT("BP_RepeatedPose"), BPTYPE_Normal, UBlueprint::StaticClass(), UBlueprintGeneratedClass::StaticClass());
+	USCS_Node* Node = Blueprint->SimpleConstructionScript->CreateNode(UStaticMeshComponent::StaticClass(), TEXT("Mesh"));
+	CastChecked<UStaticMeshComponent>(Node->ComponentTemplate)->SetStaticMesh(Cube);
+	Blueprint->SimpleConstructionScript->AddNode(Node);
+	FKismetEditorUtilities::CompileBlueprint(Blueprint);
+
+	FThumbnailCreationConfig CreationConfig;
+	CreationConfig.ThumbnailSize = 64;
+	CreationConfig.ThumbnailBackground = FLinearColor::Transparent;
+	CreationConfig.MaterialVariants.SetNum(2);
+
+	const FObjectThumbnail* Thumbnail = FThumbnailExporterRenderer::GenerateThumbnail(CreationConfig, Blueprint);
+	if (TestNotNull(TEXT("Thumbnail"), Thumbnail))
+	{
+		const TArray<uint8>& ImageData = Thumbnail->GetUncompressedImageData();
+		const int32 ImageWidth = Thumbnail->GetImageWidth();
+		const FIntPoint FrameSize(CreationConfig.ThumbnailSize, CreationConfig.ThumbnailSize);
+
+		TestTrue(TEXT("The rendered pose is drawn"), IsFrameCovered(ImageData, ImageWidth, FIntPoint(0, 0), FrameSize));
+		TestTrue(TEXT("The repeated pose is drawn"), IsFrameCovered(ImageData, ImageWidth, FIntPoint(FrameSize.X, 0), FrameSize));
+		TestTrue(TEXT("The repeated pose matches the rendered one"), AreFramesEqual(ImageData, ImageWidth, FIntPoint(0, 0), FIntPoint(FrameSize.X, 0), FrameSize));
+	}
+
+	Blueprint->ClearFlags(RF_Public | RF_Standalone);
+	Blueprint->MarkAsGarbage();
+	Package->MarkAsGarbage();
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
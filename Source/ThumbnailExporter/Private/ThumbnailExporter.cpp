@@ -11,9 +11,15 @@
 #include "Framework/Notifications/NotificationManager.h"
 #include "IContentBrowserSingleton.h"
 #include "ThumbnailExporterSettings.h"
+#include "ThumbnailExporterRuntimeSettings.h"
 #include "ThumbnailExporterRenderer.h"
 #include "BlueprintThumbnailExporterRenderer.h"
 #include "ThumbnailExporterThumbnailDummy.h"
+#include "ThumbnailExporterBatch.h"
+#include "ThumbnailExporterQueue.h"
+#include "ThumbnailExporterWatcher.h"
+
+DEFINE_LOG_CATEGORY(LogThumbnailExporter);
 
 #define LOCTEXT_NAMESPACE "FThumbnailExporterModule"
 void FThumbnailExporterModule::StartupModule()
@@ -21,11 +27,53 @@ void FThumbnailExporterModule::StartupModule()
 	UThumbnailManager::Get().RegisterCustomRenderer(UThumbnailExporterThumbnailDummy::StaticClass(), UBlueprintThumbnailExporterRenderer::StaticClass());
 
 	AddContentBrowserContextMenuExtender();
+
+	ExportQueue = MakeUnique<FThumbnailExporterQueue>();
+	Watcher = MakeUnique<FThumbnailExporterWatcher>();
+
+	UThumbnailExporterSettings::Get()->OnSettingChanged().AddRaw(this, &FThumbnailExporterModule::OnSettingsChanged);
+	UThumbnailExporterRuntimeSettings::Get()->OnSettingChanged().AddRaw(this, &FThumbnailExporterModule::OnSettingsChanged);
+	ValidateRuntimeNamingRules();
 }
 
 void FThumbnailExporterModule::ShutdownModule()
 {
 	RemoveContentBrowserContextMenuExtender();
+
+	if (UObjectInitialized())
+	{
+		UThumbnailExporterSettings::Get()->OnSettingChanged().RemoveAll(this);
+		UThumbnailExporterRuntimeSettings::Get()->OnSettingChanged().RemoveAll(this);
+	}
+
+	Watcher.Reset();
+	ExportQueue.Reset();
+}
+
+void FThumbnailExporterModule::ValidateRuntimeNamingRules()
+{
+	const FThumbnailNamingRules& RuntimeNamingRules = UThumbnailExporterRuntimeSettings::Get()->NamingRules;
+	for (const FThumbnailCreationPreset& Preset : UThumbnailExporterSettings::Get()->ThumbnailCreationPresets)
+	{
+		if (Preset.PresetConfig.GetNamingRules() == RuntimeNamingRules)
+		{
+			return;
+		}
+	}
+
+	UE_LOG(LogThumbnailExporter, Warning, TEXT("The naming rules in the Thumbnail Exporter Runtime settings (prefix \"%s\", suffix \"%s\"%s) don't match the filename settings of any thumbnail creation preset. The game won't find the exported thumbnails"),
+		*RuntimeNamingRules.ThumbnailPrefix, *RuntimeNamingRules.ThumbnailSuffix,
+		RuntimeNamingRules.bOverrideThumbnailPath ? *FString::Printf(TEXT(", path %s"), *RuntimeNamingRules.ThumbnailOverridePath.Path) : TEXT(""));
+}
+
+void FThumbnailExporterModule::OnSettingsChanged(UObject* Settings, FPropertyChangedEvent& PropertyChangedEvent)
+{
+	ValidateRuntimeNamingRules();
+}
+
+FThumbnailExporterQueue& FThumbnailExporterModule::GetExportQueue()
+{
+	return *FModuleManager::GetModuleChecked<FThumbnailExporterModule>("ThumbnailExporter").ExportQueue;
 }
 
 void FThumbnailExporterModule::AddContentBrowserContextMenuExtender()
@@ -80,6 +128,20 @@ bool FThumbnailExporterModule::CanCreateThumbnail(const TArray<FAssetData>& Sele
 	return false;
 }
 
+TArray<FAssetData> FThumbnailExporterModule::GetExportableAssets(const TArray<FAssetData>& Assets)
+{
+	TArray<FAssetData> ExportableAssets;
+	for (const FAssetData& Asset : Assets)
+	{
+		if (CanCreateThumbnail({ Asset }))
+		{
+			ExportableAssets.Add(Asset);
+		}
+	}
+
+	return ExportableAssets;
+}
+
 void FThumbnailExporterModule::ExecuteSaveThumbnailAsTexture(FMenuBuilder& MenuBuilder, const TArray<FAssetData> SelectedAssets)
 {
 	// Only create the menu if a blueprint is selected and it's renderable
@@ -100,14 +162,7 @@ void FThumbnailExporterModule::ExecuteSaveThumbnailAsTexture(FMenuBuilder& MenuB
 				FSlateIcon(),
 				FUIAction(FExecuteAction::CreateLambda([SelectedAssets]()
 				{
-					for (const FAssetData& Asset : SelectedAssets)
-					{
-						if (CanCreateThumbnail({ Asset }))
-						{
-							FString OutFilePath;
-							ExportThumbnail(UThumbnailExporterSettings::Get()->ThumbnailCreationPresets[0].PresetConfig, Asset, OutFilePath);
-						}
-					}
+					GetExportQueue().Submit(UThumbnailExporterSettings::Get()->ThumbnailCreationPresets[0].PresetConfig, GetExportableAssets(SelectedAssets));
 				})),
 				NAME_None,
 				EUserInterfaceActionType::Button
@@ -133,14 +188,7 @@ void FThumbnailExporterModule::ExecuteSaveThumbnailAsTexture(FMenuBuilder& MenuB
 							FSlateIcon(),
 							FUIAction(FExecuteAction::CreateLambda([SelectedAssets, i]()
 							{
-								for (const FAssetData& Asset : SelectedAssets)
-								{
-									if (CanCreateThumbnail({ Asset }))
-									{
-										FString OutFilePath;
-										ExportThumbnail(UThumbnailExporterSettings::Get()->ThumbnailCreationPresets[i].PresetConfig, Asset, OutFilePath);
-									}
-								}
+								GetExportQueue().Submit(UThumbnailExporterSettings::Get()->ThumbnailCreationPresets[i].PresetConfig, GetExportableAssets(SelectedAssets));
 							})),
 							NAME_None,
 							EUserInterfaceActionType::Button
@@ -157,29 +205,14 @@ void FThumbnailExporterModule::ExecuteSaveThumbnailAsTexture(FMenuBuilder& MenuB
 
 bool FThumbnailExporterModule::GetThumbnailAssetPathAndFilename(const FThumbnailCreationConfig& CreationConfig, const FAssetData& Asset, FString& Path, FString& Filename)
 {
-	const FString AssetPath = Asset.GetAsset()->GetPathName();
-
-	FString FullPath;
+	// Same rules as the runtime uses to find the thumbnail
+	TOptional<FString> OverrideFilename;
 	if (CreationConfig.bOverrideThumbnailFilename)
 	{
-		FullPath = CreationConfig.ThumbnailOverrideFilename;
+		OverrideFilename = CreationConfig.ThumbnailOverrideFilename;
 	}
-	else
-	{
-		const FString& Prefix = CreationConfig.ThumbnailPrefix;
-		const FString& Suffix = CreationConfig.ThumbnailSuffix;
 
-		FullPath = Prefix + FPaths::GetBaseFilename(AssetPath) + Suffix;
-	}
-
-	if (CreationConfig.bOverrideThumbnailPath)
-	{
-		FullPath = CreationConfig.ThumbnailOverridePath.Path / FullPath;
-	}
-	else
-	{
-		FullPath = FPaths::GetPath(AssetPath) / FullPath;
-	}
+	const FString FullPath = FThumbnailExporterNaming::GetThumbnailPackageName(CreationConfig.GetNamingRules(), Asset.GetObjectPathString(), OverrideFilename);
 
 	Path = FPaths::GetPath(FullPath);
 	Filename = FPaths::GetBaseFilename(FullPath);
@@ -187,78 +220,22 @@ bool FThumbnailExporterModule::GetThumbnailAssetPathAndFilename(const FThumbnail
 	return true;
 }
 
-static UPackage* GetAssetPackage(const FThumbnailCreationConfig& CreationConfig, const FString& FullPath)
+bool FThumbnailExporterModule::ExportThumbnail(const FThumbnailCreationConfig& CreationConfig, const FAssetData& Asset, FString& ThumbnailPath, const FPreCreateThumbnail& CreationDelegate)
 {
-	UPackage* Package = CreatePackage(*FullPath);
-	if (Package != nullptr)
-	{
-		Package->FullyLoad();
-	}
+	FThumbnailExporterBatch Batch(CreationConfig, { Asset }, CreationDelegate);
+	Batch.ExportAll();
 
-	return Package;
+	const FThumbnailExportResult& Result = Batch.GetReport().Results[0];
+	ThumbnailPath = Result.ThumbnailPath;
+	return Result.bSuccess;
 }
 
-bool FThumbnailExporterModule::ExportThumbnail(const FThumbnailCreationConfig& CreationConfig, const FAssetData& Asset, FString& ThumbnailPath, const FPreCreateThumbnail& CreationDelegate)
+FThumbnailExportBatchReport FThumbnailExporterModule::ExportThumbnails(const FThumbnailCreationConfig& CreationConfig, const TArray<FAssetData>& Assets, const FPreCreateThumbnail& CreationDelegate)
 {
-	FThumbnailCreationConfig ModifiedCreationConfig = CreationConfig;
+	FThumbnailExporterBatch Batch(CreationConfig, Assets, CreationDelegate);
+	Batch.ExportAll();
 
-	FString AssetPath, AssetFilename;
-	if (!GetThumbnailAssetPathAndFilename(ModifiedCreationConfig, Asset, AssetPath, AssetFilename))
-	{
-		return false;
-	}
-	ThumbnailPath = AssetPath / AssetFilename;
-
-	UPackage* Package = GetAssetPackage(ModifiedCreationConfig, ThumbnailPath);
-	if (Package == nullptr)
-	{
-		return false;
-	}
-
-	FObjectThumbnail* Thumb = FThumbnailExporterRenderer::GenerateThumbnail(ModifiedCreationConfig, Asset.GetAsset(), CreationDelegate);
-	if (!Thumb)
-	{
-		return false;
-	}
-
-	UTexture2D* NewTexture = NewObject<UTexture2D>(Package, *AssetFilename, RF_Public | RF_Standalone);
-	NewTexture->AddToRoot();
-	FTexturePlatformData* PlatformData = new FTexturePlatformData();
-	PlatformData->SizeX = Thumb->GetImageWidth();
-	PlatformData->SizeY = Thumb->GetImageHeight();
-	PlatformData->PixelFormat = EPixelFormat::PF_B8G8R8A8;
-	NewTexture->SetPlatformData(PlatformData);
-
-	FTexture2DMipMap* Mip = new FTexture2DMipMap();
-	PlatformData->Mips.Add(Mip);
-	Mip->SizeX = Thumb->GetImageWidth();
-	Mip->SizeY = Thumb->GetImageHeight();
-
-	Mip->BulkData.Lock(LOCK_READ_WRITE);
-	uint8* TextureData = (uint8*)Mip->BulkData.Realloc(Thumb->GetUncompressedImageData().Num());
-	FMemory::Memcpy(TextureData, Thumb->GetUncompressedImageData().GetData(), Thumb->GetUncompressedImageData().Num());
-	Mip->BulkData.Unlock();
-
-	NewTexture->Source.Init(Thumb->GetImageWidth(), Thumb->GetImageHeight(), 1, 1, ETextureSourceFormat::TSF_BGRA8, Thumb->GetUncompressedImageData().GetData());
-	NewTexture->LODGroup = ModifiedCreationConfig.ThumbnailTextureGroup;
-	NewTexture->UpdateResource();
-	Package->MarkPackageDirty();
-	Package->FullyLoad();
-	FAssetRegistryModule::AssetCreated(NewTexture);
-
-	FSavePackageArgs SaveArgs;
-	SaveArgs.TopLevelFlags = EObjectFlags::RF_Public | EObjectFlags::RF_Standalone;
-	SaveArgs.SaveFlags = SAVE_NoError;
-	SaveArgs.bForceByteSwapping = true;
-	FString PackageFileName = FPackageName::LongPackageNameToFilename(ThumbnailPath, FPackageName::GetAssetPackageExtension());
-	UPackage::SavePackage(Package, NewTexture, *PackageFileName, SaveArgs);
-
-	if (ModifiedCreationConfig.bCreateThumbnailNotification)
-	{
-		CreateThumbnailNotification(NewTexture);
-	}
-
-	return true;
+	return Batch.GetReport();
 }
 
 void FThumbnailExporterModule::CreateThumbnailNotification(UTexture2D* NewTexture)
@@ -0,0 +1,73 @@
+// Copyright 2023 Big Cat Energising. All Rights Reserved.
+
+
+#include "ThumbnailExporterAsyncExport.h"
+
+#include "ThumbnailExporter.h"
+#include "ThumbnailExporterQueue.h"
+
+UThumbnailExporterAsyncExport* UThumbnailExporterAsyncExport::ExportThumbnailsAsync(const FThumbnailCreationConfig& CreationConfig, const TArray<FAssetData>& Assets, const FPreCreateThumbnail& CreationDelegate)
+{
+	UThumbnailExporterAsyncExport* Action = NewObject<UThumbnailExporterAsyncExport>();
+	Action->CreationConfig = CreationConfig;
+	Action->Assets = Assets;
+	Action->CreationDelegate = CreationDelegate;
+	return Action;
+}
+
+void UThumbnailExporterAsyncExport::Activate()
+{
+	if (JobId != INDEX_NONE)
+	{
+		return;
+	}
+
+	// There is no game instance to register with in the editor, so keep the action alive until the job is done
+	AddToRoot();
+
+	JobId = FThumbnailExporterModule::GetExportQueue().Submit(CreationConfig, Assets, CreationDelegate,
+		FOnThumbnailExported::CreateUObject(this, &UThumbnailExporterAsyncExport::HandleThumbnailExported),
+		FOnThumbnailExportJobFinished::CreateUObject(this, &UThumbnailExporterAsyncExport::HandleJobFinished));
+}
+
+void UThumbnailExporterAsyncExport::Cancel()
+{
+	// Finishing the job already broadcast OnCompleted and got the action ready to be destroyed
+	if (bFinished)
+	{
+		return;
+	}
+
+	// Finishes the job right away, which broadcasts OnCompleted with the remaining assets marked as cancelled and cleans up through HandleJobFinished
+	if (JobId != INDEX_NONE && FThumbnailExporterModule::GetExportQueue().Cancel(JobId))
+	{
+		return;
+	}
+
+	Super::Cancel();
+}
+
+bool UThumbnailExporterAsyncExport::IsActive() const
+{
+	return JobId != INDEX_NONE;
+}
+
+void UThumbnailExporterAsyncExport::HandleThumbnailExported(const FThumbnailExportResult& Result)
+{
+	OnThumbnailExported.Broadcast(Result);
+}
+
+void UThumbnailExporterAsyncExport::HandleJobFinished(const FThumbnailExportBatchReport& Report)
+{
+	if (bFinished)
+	{
+		return;
+	}
+
+	bFinished = true;
+	JobId = INDEX_NONE;
+	OnCompleted.Broadcast(Report);
+
+	RemoveFromRoot();
+	SetReadyToDestroy();
+}
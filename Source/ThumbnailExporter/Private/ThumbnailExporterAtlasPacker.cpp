@@ -0,0 +1,131 @@
+// Copyright 2023 Big Cat Energising. All Rights Reserved.
+
+
+#include "ThumbnailExporterAtlasPacker.h"
+
+FThumbnailExporterAtlasPacker::FThumbnailExporterAtlasPacker(int32 InPageSizeX, int32 InPageSizeY, int32 InPadding)
+	: PageSizeX(InPageSizeX)
+	, PageSizeY(InPageSizeY)
+	, Padding(FMath::Max(InPadding, 0))
+{
+
+}
+
+bool FThumbnailExporterAtlasPacker::AddRect(int32 SizeX, int32 SizeY, int32& OutPage, FIntPoint& OutPosition)
+{
+	// Padding is only needed between rectangles, so the right and bottom edges of the page can be used for it
+	const int32 PaddedSizeX = FMath::Min(SizeX + Padding, PageSizeX);
+	const int32 PaddedSizeY = FMath::Min(SizeY + Padding, PageSizeY);
+	if (SizeX > PageSizeX || SizeY > PageSizeY)
+	{
+		return false;
+	}
+
+	for (int32 PageIndex = 0; PageIndex < Pages.Num(); ++PageIndex)
+	{
+		const int32 NodeIndex = FindPosition(Pages[PageIndex], PaddedSizeX, PaddedSizeY, OutPosition);
+		if (NodeIndex != INDEX_NONE)
+		{
+			AddToSkyline(Pages[PageIndex], NodeIndex, OutPosition, PaddedSizeX, PaddedSizeY);
+			OutPage = PageIndex;
+			return true;
+		}
+	}
+
+	FPage& NewPage = AddPage();
+	const int32 NodeIndex = FindPosition(NewPage, PaddedSizeX, PaddedSizeY, OutPosition);
+	check(NodeIndex != INDEX_NONE);
+	AddToSkyline(NewPage, NodeIndex, OutPosition, PaddedSizeX, PaddedSizeY);
+	OutPage = Pages.Num() - 1;
+	return true;
+}
+
+int32 FThumbnailExporterAtlasPacker::FindPosition(const FPage& Page, int32 SizeX, int32 SizeY, FIntPoint& OutPosition) const
+{
+	int32 BestNodeIndex = INDEX_NONE;
+	int32 BestBottom = MAX_int32;
+	int32 BestWidth = MAX_int32;
+
+	for (int32 NodeIndex = 0; NodeIndex < Page.Skyline.Num(); ++NodeIndex)
+	{
+		const int32 X = Page.Skyline[NodeIndex].X;
+		if (X + SizeX > PageSizeX)
+		{
+			break;
+		}
+
+		// The rectangle rests on the highest segment it spans
+		int32 Y = 0;
+		int32 RemainingWidth = SizeX;
+		for (int32 SpanIndex = NodeIndex; RemainingWidth > 0; ++SpanIndex)
+		{
+			const FSkylineNode& SpanNode = Page.Skyline[SpanIndex];
+			Y = FMath::Max(Y, SpanNode.Y);
+			RemainingWidth -= SpanNode.Width;
+		}
+
+		if (Y + SizeY > PageSizeY)
+		{
+			continue;
+		}
+
+		const int32 Bottom = Y + SizeY;
+		if (Bottom < BestBottom || (Bottom == BestBottom && Page.Skyline[NodeIndex].Width < BestWidth))
+		{
+			BestNodeIndex = NodeIndex;
+			BestBottom = Bottom;
+			BestWidth = Page.Skyline[NodeIndex].Width;
+			OutPosition = FIntPoint(X, Y);
+		}
+	}
+
+	return BestNodeIndex;
+}
+
+void FThumbnailExporterAtlasPacker::AddToSkyline(FPage& Page, int32 NodeIndex, const FIntPoint& Position, int32 SizeX, int32 SizeY)
+{
+	Page.Skyline.Insert(FSkylineNode{ Position.X, Position.Y + SizeY, SizeX }, NodeIndex);
+
+	// Trim or remove the segments that are now under the new one
+	const int32 NewNodeEnd = Position.X + SizeX;
+	for (int32 i = NodeIndex + 1; i < Page.Skyline.Num();)
+	{
+		FSkylineNode& Node = Page.Skyline[i];
+		if (Node.X >= NewNodeEnd)
+		{
+			break;
+		}
+
+		const int32 NodeEnd = Node.X + Node.Width;
+		if (NodeEnd <= NewNodeEnd)
+		{
+			Page.Skyline.RemoveAt(i);
+			continue;
+		}
+
+		Node.Width = NodeEnd - NewNodeEnd;
+		Node.X = NewNodeEnd;
+		break;
+	}
+
+	// Merge neighbouring segments at the same height
+	for (int32 i = 0; i + 1 < Page.Skyline.Num();)
+	{
+		if (Page.Skyline[i].Y == Page.Skyline[i + 1].Y)
+		{
+			Page.Skyline[i].Width += Page.Skyline[i + 1].Width;
+			Page.Skyline.RemoveAt(i + 1);
+		}
+		else
+		{
+			++i;
+		}
+	}
+}
+
+FThumbnailExporterAtlasPacker::FPage& FThumbnailExporterAtlasPacker::AddPage()
+{
+	FPage& Page = Pages.AddDefaulted_GetRef();
+	Page.Skyline.Add(FSkylineNode{ 0, 0, PageSizeX });
+	return Page;
+}
@@ -0,0 +1,1035 @@
+// Copyright 2023 Big Cat Energising. All Rights Reserved.
+
+
+#include "ThumbnailExporterBatch.h"
+
+#include "ThumbnailExporter.h"
+#include "ThumbnailExporterRenderer.h"
+#include "ThumbnailExporterImageUtils.h"
+#include "ThumbnailExporterManifest.h"
+#include "ThumbnailExporterAtlasPacker.h"
+#include "ThumbnailExporterCache.h"
+#include "ThumbnailExporterScene.h"
+#include "ObjectTools.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Engine/Blueprint.h"
+#include "UObject/SavePackage.h"
+#include "UObject/MetaData.h"
+#include "TextureCompiler.h"
+#include "DeviceProfiles/DeviceProfile.h"
+#include "DeviceProfiles/DeviceProfileManager.h"
+#include "ImageUtils.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "IImageWrapper.h"
+#include "IImageWrapperModule.h"
+#include "Hash/xxhash.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/JsonWriter.h"
+
+// Package metadata key used to store the hash of the thumbnail that was written to the texture
+static const TCHAR* ThumbnailHashMetaDataKey = TEXT("ThumbnailExporter.ThumbnailHash");
+
+// Bump this if the way thumbnails are written changes, so existing thumbnails get rewritten
+static const uint32 ThumbnailHashVersion = 1;
+
+// Result of the worker thread part of the export
+struct FEncodedThumbnail
+{
+	// Hash of the pixels and of the settings used to build the texture
+	uint64 Hash = 0;
+
+	// PNG compressed pixels. Empty if the source is stored uncompressed
+	TArray64<uint8> CompressedSource;
+
+	// Time the worker spent encoding
+	double EncodeSeconds = 0.0;
+};
+
+struct FThumbnailExporterBatch::FPendingThumbnail
+{
+	// Copy of the creation config, the creation delegate is allowed to modify it while rendering
+	FThumbnailCreationConfig CreationConfig;
+	int32 ResultIndex = INDEX_NONE;
+
+	FString ThumbnailPath;
+	FString AssetFilename;
+
+	int32 SizeX = 0;
+	int32 SizeY = 0;
+	TArray<FColor> Pixels;
+
+	// Hash and PNG compressed copy of Pixels, encoded on a worker thread
+	TFuture<FEncodedThumbnail> Encoded;
+
+	// Size of Pixels counted in STAT_ThumbnailExporter_PendingThumbnailMemory
+	int64 TrackedMemory = 0;
+
+	~FPendingThumbnail()
+	{
+		DEC_MEMORY_STAT_BY(STAT_ThumbnailExporter_PendingThumbnailMemory, TrackedMemory);
+	}
+};
+
+// Hashes the texture settings along with the pixels, so changing the settings rewrites the texture even if the pixels are the same
+static void HashTextureSettings(FXxHash64Builder& Builder, const FThumbnailCreationConfig& CreationConfig)
+{
+	const uint8 Settings[] = {
+		(uint8)CreationConfig.ThumbnailTextureGroup,
+		(uint8)CreationConfig.ThumbnailCompressionSettings,
+		(uint8)CreationConfig.ThumbnailMipGenSettings,
+		(uint8)CreationConfig.bAlphaAwareMipFiltering,
+		(uint8)CreationConfig.bStreamable,
+		(uint8)CreationConfig.bCompressTextureSource
+	};
+
+	Builder.Update(&ThumbnailHashVersion, sizeof(ThumbnailHashVersion));
+	Builder.Update(Settings, sizeof(Settings));
+}
+
+static FString GetThumbnailHashString(uint64 Hash)
+{
+	return FString::Printf(TEXT("%016llx"), Hash);
+}
+
+// Returns true if a thumbnail texture was already exported to ThumbnailPath.
+// OutHash is set to the hash stored on it, or left empty if it was exported without one
+static bool GetExistingThumbnailHash(const FString& ThumbnailPath, const FString& AssetFilename, FString& OutHash)
+{
+	OutHash.Empty();
+
+	if (!FPackageName::DoesPackageExist(ThumbnailPath))
+	{
+		return false;
+	}
+
+	const FString ObjectPath = ThumbnailPath + TEXT(".") + AssetFilename;
+	UTexture2D* ExistingTexture = LoadObject<UTexture2D>(nullptr, *ObjectPath, nullptr, LOAD_NoWarn | LOAD_Quiet);
+	if (ExistingTexture == nullptr)
+	{
+		return false;
+	}
+
+	UMetaData* MetaData = ExistingTexture->GetOutermost()->GetMetaData();
+	if (MetaData != nullptr && MetaData->HasValue(ExistingTexture, ThumbnailHashMetaDataKey))
+	{
+		OutHash = MetaData->GetValue(ExistingTexture, ThumbnailHashMetaDataKey);
+	}
+
+	return true;
+}
+
+static UPackage* GetAssetPackage(const FThumbnailCreationConfig& CreationConfig, const FString& FullPath)
+{
+	UPackage* Package = CreatePackage(*FullPath);
+	if (Package != nullptr)
+	{
+		Package->FullyLoad();
+	}
+
+	return Package;
+}
+
+static void SaveAssetPackage(UPackage* Package, UObject* Asset, const FString& FullPath)
+{
+	SCOPE_THUMBNAIL_EXPORT_STAGE(SavePackage);
+
+	FSavePackageArgs SaveArgs;
+	SaveArgs.TopLevelFlags = EObjectFlags::RF_Public | EObjectFlags::RF_Standalone;
+	SaveArgs.SaveFlags = SAVE_NoError;
+	SaveArgs.bForceByteSwapping = true;
+	FString PackageFileName = FPackageName::LongPackageNameToFilename(FullPath, FPackageName::GetAssetPackageExtension());
+	UPackage::SavePackage(Package, Asset, *PackageFileName, SaveArgs);
+}
+
+// Thumbnail packages contain a single asset with the same name as the package
+static FSoftObjectPath GetThumbnailObjectPath(const FString& ThumbnailPath)
+{
+	return FSoftObjectPath(ThumbnailPath + TEXT(".") + FPackageName::GetShortName(ThumbnailPath));
+}
+
+// Hashes the pixels and optionally PNG compresses them. Safe to call from worker threads
+static FEncodedThumbnail EncodeThumbnail(TArrayView<const FColor> Pixels, int32 SizeX, int32 SizeY, const FThumbnailCreationConfig& CreationConfig, bool bCompressSource)
+{
+	SCOPE_THUMBNAIL_EXPORT_STAGE(Encode);
+	const double StartTime = FPlatformTime::Seconds();
+
+	FEncodedThumbnail Encoded;
+
+	FXxHash64Builder HashBuilder;
+	HashBuilder.Update(&SizeX, sizeof(SizeX));
+	HashBuilder.Update(&SizeY, sizeof(SizeY));
+	HashBuilder.Update(Pixels.GetData(), Pixels.Num() * sizeof(FColor));
+	HashTextureSettings(HashBuilder, CreationConfig);
+	Encoded.Hash = HashBuilder.Finalize().Hash;
+
+	if (bCompressSource)
+	{
+		IImageWrapperModule& ImageWrapperModule = FModuleManager::GetModuleChecked<IImageWrapperModule>("ImageWrapper");
+		TSharedPtr<IImageWrapper> ImageWrapper = ImageWrapperModule.CreateImageWrapper(EImageFormat::PNG);
+		if (ImageWrapper.IsValid() && ImageWrapper->SetRaw(Pixels.GetData(), Pixels.Num() * sizeof(FColor), SizeX, SizeY, ERGBFormat::BGRA, 8))
+		{
+			Encoded.CompressedSource = ImageWrapper->GetCompressed();
+		}
+	}
+
+	Encoded.EncodeSeconds = FPlatformTime::Seconds() - StartTime;
+	return Encoded;
+}
+
+// Whether the thumbnail textures end up with mips. FromTextureGroup depends on the group, e.g. the default UI group has none
+static bool GeneratesMips(const FThumbnailCreationConfig& CreationConfig)
+{
+	TextureMipGenSettings MipGenSettings = CreationConfig.ThumbnailMipGenSettings;
+	if (MipGenSettings == TextureMipGenSettings::TMGS_FromTextureGroup)
+	{
+		const UDeviceProfile* DeviceProfile = UDeviceProfileManager::Get().GetActiveProfile();
+		if (DeviceProfile == nullptr)
+		{
+			return false;
+		}
+		MipGenSettings = DeviceProfile->GetTextureLODSettings()->GetTextureMipGenSettings(CreationConfig.ThumbnailTextureGroup);
+	}
+	return MipGenSettings != TextureMipGenSettings::TMGS_NoMipmaps;
+}
+
+// Writes the pixels to the texture asset at TexturePath, unless the existing texture is identical.
+// Returns New, Changed or Identical, or Failed if the texture couldn't be written
+static EThumbnailExportStatus WriteThumbnailTexture(const FThumbnailCreationConfig& CreationConfig, const FString& TexturePath, int32 SizeX, int32 SizeY,
+	TArrayView<const FColor> Pixels, const FEncodedThumbnail& Encoded, int64& OutStoredSourceBytes)
+{
+	const FString TextureName = FPackageName::GetShortName(TexturePath);
+	const FString ThumbnailHash = GetThumbnailHashString(Encoded.Hash);
+
+	FString ExistingThumbnailHash;
+	const bool bThumbnailExists = GetExistingThumbnailHash(TexturePath, TextureName, ExistingThumbnailHash);
+	if (CreationConfig.bSkipUnchangedThumbnails && ExistingThumbnailHash == ThumbnailHash)
+	{
+		// Leave the package untouched so it doesn't show up as modified in source control
+		OutStoredSourceBytes = 0;
+		return EThumbnailExportStatus::Identical;
+	}
+
+	UPackage* Package = GetAssetPackage(CreationConfig, TexturePath);
+	if (Package == nullptr)
+	{
+		return EThumbnailExportStatus::Failed;
+	}
+
+	const int64 RawSourceBytes = Pixels.Num() * sizeof(FColor);
+
+	UTexture2D* NewTexture = NewObject<UTexture2D>(Package, *TextureName, RF_Public | RF_Standalone);
+	NewTexture->AddToRoot();
+
+	// Fall back to the raw source if the PNG didn't end up smaller (or failed to encode)
+	const TArray64<uint8>& CompressedSource = Encoded.CompressedSource;
+	if (CompressedSource.Num() > 0 && CompressedSource.Num() < RawSourceBytes)
+	{
+		NewTexture->Source.InitWithCompressedSourceData(SizeX, SizeY, 1, ETextureSourceFormat::TSF_BGRA8, CompressedSource, ETextureSourceCompressionFormat::TSCF_PNG);
+		OutStoredSourceBytes = CompressedSource.Num();
+	}
+	else
+	{
+		NewTexture->Source.Init(SizeX, SizeY, 1, 1, ETextureSourceFormat::TSF_BGRA8, (const uint8*)Pixels.GetData());
+		OutStoredSourceBytes = RawSourceBytes;
+	}
+
+	NewTexture->LODGroup = CreationConfig.ThumbnailTextureGroup;
+	NewTexture->CompressionSettings = CreationConfig.ThumbnailCompressionSettings;
+	NewTexture->MipGenSettings = CreationConfig.ThumbnailMipGenSettings;
+	NewTexture->NeverStream = !CreationConfig.bStreamable;
+	NewTexture->SRGB = true;
+	if (GeneratesMips(CreationConfig) && CreationConfig.bAlphaAwareMipFiltering)
+	{
+		NewTexture->bDoScaleMipsForAlphaCoverage = true;
+		NewTexture->AlphaCoverageThresholds = FVector4(0, 0, 0, 0.5f);
+	}
+
+	// Build the platform data through the regular texture build so it gets compressed, mipped and cached in the DDC
+	{
+		SCOPE_THUMBNAIL_EXPORT_STAGE(TextureBuild);
+		NewTexture->PostEditChange();
+		FTextureCompilingManager::Get().FinishCompilation({ NewTexture });
+	}
+
+	Package->GetMetaData()->SetValue(NewTexture, ThumbnailHashMetaDataKey, *ThumbnailHash);
+
+	Package->MarkPackageDirty();
+	Package->FullyLoad();
+	FAssetRegistryModule::AssetCreated(NewTexture);
+
+	SaveAssetPackage(Package, NewTexture, TexturePath);
+
+	// Only rooted while it was being built and saved
+	NewTexture->RemoveFromRoot();
+
+	if (CreationConfig.bCreateThumbnailNotification)
+	{
+		FThumbnailExporterModule::CreateThumbnailNotification(NewTexture);
+	}
+
+	return bThumbnailExists ? EThumbnailExportStatus::Changed : EThumbnailExportStatus::New;
+}
+
+// Crops the thumbnail to the visible part of the asset (plus padding). Depending on the crop mode the cropped
+// pixels are either scaled back up and centered in the original size, or become the new, smaller thumbnail
+static void CropThumbnail(const FThumbnailCreationConfig& CreationConfig, int32& SizeX, int32& SizeY, TArray<FColor>& Pixels)
+{
+	FIntRect Bounds;
+	if (!FThumbnailExporterImageUtils::FindOpaqueBounds(Pixels, SizeX, SizeY, (uint8)FMath::Clamp(CreationConfig.CropAlphaThreshold, 0, 254), Bounds))
+	{
+		// Nothing visible to crop to
+		return;
+	}
+
+	const FIntRect ImageRect(0, 0, SizeX, SizeY);
+	Bounds.InflateRect(FMath::Max(CreationConfig.CropPadding, 0));
+	Bounds.Clip(ImageRect);
+	if (Bounds == ImageRect)
+	{
+		return;
+	}
+
+	TArray<FColor> CroppedPixels = FThumbnailExporterImageUtils::CropImage(Pixels, SizeX, SizeY, Bounds);
+	const int32 CroppedSizeX = Bounds.Width();
+	const int32 CroppedSizeY = Bounds.Height();
+
+	if (CreationConfig.CropMode == EThumbnailCropMode::Crop)
+	{
+		SizeX = CroppedSizeX;
+		SizeY = CroppedSizeY;
+		Pixels = MoveTemp(CroppedPixels);
+		return;
+	}
+
+	// Scale the longest side of the cropped pixels up to the thumbnail size, keeping the aspect ratio
+	const float Scale = FMath::Min((float)SizeX / CroppedSizeX, (float)SizeY / CroppedSizeY);
+	const int32 ScaledSizeX = FMath::Clamp(FMath::RoundToInt(CroppedSizeX * Scale), 1, SizeX);
+	const int32 ScaledSizeY = FMath::Clamp(FMath::RoundToInt(CroppedSizeY * Scale), 1, SizeY);
+
+	TArray<FColor> ScaledPixels;
+	FImageUtils::ImageResize(CroppedSizeX, CroppedSizeY, CroppedPixels, ScaledSizeX, ScaledSizeY, ScaledPixels, false, false);
+
+	// Center the scaled pixels on the background
+	const FColor BackgroundColor = CreationConfig.ThumbnailBackground.ToFColor(true);
+	for (FColor& Pixel : Pixels)
+	{
+		Pixel = BackgroundColor;
+	}
+
+	const int32 OffsetX = (SizeX - ScaledSizeX) / 2;
+	const int32 OffsetY = (SizeY - ScaledSizeY) / 2;
+	for (int32 Y = 0; Y < ScaledSizeY; ++Y)
+	{
+		FMemory::Memcpy(&Pixels[(OffsetY + Y) * SizeX + OffsetX], &ScaledPixels[Y * ScaledSizeX], ScaledSizeX * sizeof(FColor));
+	}
+}
+
+FThumbnailExporterBatch::FThumbnailExporterBatch(const FThumbnailCreationConfig& InCreationConfig, const TArray<FAssetData>& InAssets, const FPreCreateThumbnail& InCreationDelegate, const FOnThumbnailExported& InOnThumbnailExported)
+	: CreationConfig(InCreationConfig)
+	, Assets(InAssets)
+	, CreationDelegate(InCreationDelegate)
+	, OnThumbnailExported(InOnThumbnailExported)
+	, StartTime(FPlatformTime::Seconds())
+{
+	Report.Results.Reserve(Assets.Num());
+
+	if (CreationConfig.bCompressTextureSource)
+	{
+		// The image wrapper module has to be loaded on the game thread before the workers can use it
+		FModuleManager::LoadModuleChecked<IImageWrapperModule>("ImageWrapper");
+	}
+}
+
+FThumbnailExporterBatch::~FThumbnailExporterBatch()
+{
+	// Don't leave a rendered thumbnail unwritten
+	if (PendingThumbnail.IsValid())
+	{
+		WriteThumbnail(*PendingThumbnail);
+		PendingThumbnail.Reset();
+	}
+
+	for (const FAtlasImage& Image : AtlasImages)
+	{
+		DEC_MEMORY_STAT_BY(STAT_ThumbnailExporter_AtlasImageMemory, Image.Pixels.GetAllocatedSize());
+	}
+}
+
+bool FThumbnailExporterBatch::ExportNext()
+{
+	if (bFinished)
+	{
+		return false;
+	}
+
+	if (NextAssetIndex < Assets.Num())
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(FThumbnailExporterBatch::ExportNext, ThumbnailExporterChannel);
+
+		const FAssetData& Asset = Assets[NextAssetIndex++];
+
+		FThumbnailExportResult& Result = Report.Results.AddDefaulted_GetRef();
+		Result.Asset = Asset;
+
+		// Render this thumbnail while the previous one is being encoded, then write the previous one
+		TUniquePtr<FPendingThumbnail> RenderedThumbnail;
+		{
+			TGuardValue<FThumbnailExportStageTimings*> ActiveTimings(FThumbnailExportStageScope::ActiveTimings, &Result.Timings);
+			RenderedThumbnail = RenderThumbnail(Asset, Result);
+		}
+		if (RenderedThumbnail.IsValid())
+		{
+			RenderedThumbnail->ResultIndex = Report.Results.Num() - 1;
+		}
+		else
+		{
+			BroadcastResult(Report.Results.Num() - 1);
+		}
+
+		if (PendingThumbnail.IsValid())
+		{
+			WriteThumbnail(*PendingThumbnail);
+		}
+		PendingThumbnail = MoveTemp(RenderedThumbnail);
+	}
+
+	if (NextAssetIndex >= Assets.Num())
+	{
+		Finish();
+	}
+
+	return !bFinished;
+}
+
+void FThumbnailExporterBatch::ExportAll()
+{
+	while (ExportNext())
+	{
+	}
+}
+
+void FThumbnailExporterBatch::Finish()
+{
+	if (bFinished)
+	{
+		return;
+	}
+
+	if (PendingThumbnail.IsValid())
+	{
+		WriteThumbnail(*PendingThumbnail);
+		PendingThumbnail.Reset();
+	}
+
+	// Anything that wasn't processed counts as failed, or cancelled
+	for (; NextAssetIndex < Assets.Num(); ++NextAssetIndex)
+	{
+		FThumbnailExportResult& Result = Report.Results.AddDefaulted_GetRef();
+		Result.Asset = Assets[NextAssetIndex];
+		if (bCancelled)
+		{
+			Result.Status = EThumbnailExportStatus::Cancelled;
+		}
+		BroadcastResult(Report.Results.Num() - 1);
+	}
+
+	// Time spent on the batch as a whole goes straight into the report
+	TGuardValue<FThumbnailExportStageTimings*> ActiveTimings(FThumbnailExportStageScope::ActiveTimings, &Report.Timings);
+
+	if (CreationConfig.bPackIntoAtlas)
+	{
+		TArray<int32> AtlasResultIndices;
+		for (const FAtlasImage& Image : AtlasImages)
+		{
+			AtlasResultIndices.Append(Image.ResultIndices);
+		}
+
+		WriteAtlas();
+
+		for (int32 ResultIndex : AtlasResultIndices)
+		{
+			BroadcastResult(ResultIndex);
+		}
+	}
+
+	for (const FThumbnailExportResult& Result : Report.Results)
+	{
+		Report.Timings += Result.Timings;
+
+		switch (Result.Status)
+		{
+		case EThumbnailExportStatus::New:
+			Report.NumNew++;
+			break;
+		case EThumbnailExportStatus::Changed:
+			Report.NumChanged++;
+			break;
+		case EThumbnailExportStatus::Identical:
+			Report.NumIdentical++;
+			break;
+		case EThumbnailExportStatus::Deduplicated:
+			Report.NumDeduplicated++;
+			break;
+		case EThumbnailExportStatus::Atlased:
+			Report.NumAtlased++;
+			break;
+		case EThumbnailExportStatus::Cancelled:
+			Report.NumCancelled++;
+			break;
+		case EThumbnailExportStatus::Skipped:
+			Report.NumSkipped++;
+			break;
+		default:
+			break;
+		}
+
+		if (Result.bFromCache)
+		{
+			Report.NumFromCache++;
+		}
+
+		if (Result.bSuccess)
+		{
+			Report.NumExported++;
+			Report.RawSourceBytes += Result.RawSourceBytes;
+			Report.StoredSourceBytes += Result.StoredSourceBytes;
+		}
+		else if (Result.Status != EThumbnailExportStatus::Cancelled && Result.Status != EThumbnailExportStatus::Skipped)
+		{
+			Report.NumFailed++;
+		}
+	}
+
+	Report.RawSourceBytes += AtlasRawSourceBytes;
+	Report.StoredSourceBytes += AtlasStoredSourceBytes;
+
+	if (CreationConfig.WritesManifest())
+	{
+		WriteManifest();
+	}
+
+	// Only once the manifest no longer points into them
+	if (CreationConfig.bPackIntoAtlas && Report.AtlasPagePaths.Num() > 0 && !Report.ManifestPath.IsEmpty())
+	{
+		DeleteStaleAtlasPages();
+	}
+
+	bFinished = true;
+	Report.TotalSeconds = FPlatformTime::Seconds() - StartTime;
+
+	if (CreationConfig.bWriteTimingReport)
+	{
+		WriteTimingReport();
+	}
+
+	UE_LOG(LogThumbnailExporter, Log, TEXT("Exported %d thumbnails in %.2f s (%d new, %d changed, %d identical, %d deduplicated, %d atlased, %d failed, %d cancelled, %d skipped, %d from the derived data cache). Texture source size: %.2f MB raw, %.2f MB stored, %.2f MB saved"),
+		Report.NumExported, Report.TotalSeconds, Report.NumNew, Report.NumChanged, Report.NumIdentical, Report.NumDeduplicated, Report.NumAtlased, Report.NumFailed, Report.NumCancelled, Report.NumSkipped, Report.NumFromCache,
+		Report.RawSourceBytes / (1024.0 * 1024.0), Report.StoredSourceBytes / (1024.0 * 1024.0), Report.GetSourceBytesSaved() / (1024.0 * 1024.0));
+}
+
+void FThumbnailExporterBatch::Cancel()
+{
+	if (!bFinished)
+	{
+		bCancelled = true;
+		Finish();
+	}
+}
+
+TUniquePtr<FThumbnailExporterBatch::FPendingThumbnail> FThumbnailExporterBatch::RenderThumbnail(const FAssetData& Asset, FThumbnailExportResult& Result)
+{
+	TUniquePtr<FPendingThumbnail> Pending = MakeUnique<FPendingThumbnail>();
+	Pending->CreationConfig = CreationConfig;
+
+	FString AssetPath;
+	if (!FThumbnailExporterModule::GetThumbnailAssetPathAndFilename(Pending->CreationConfig, Asset, AssetPath, Pending->AssetFilename))
+	{
+		return nullptr;
+	}
+	Pending->ThumbnailPath = AssetPath / Pending->AssetFilename;
+	Result.ThumbnailPath = Pending->ThumbnailPath;
+	Result.NumFrames = Pending->CreationConfig.GetNumFrames();
+	Result.NumFrameColumns = Pending->CreationConfig.GetFrameGridSize().X;
+
+	// The creation delegate can change anything about the thumbnail, so there's no way to tell whether a cached one is still right
+	FString CacheKey;
+	if (Pending->CreationConfig.bUseDerivedDataCache && !CreationDelegate.IsBound())
+	{
+		SCOPE_THUMBNAIL_EXPORT_STAGE(DerivedDataCache);
+
+		if (FThumbnailExporterCache::GetCacheKey(Pending->CreationConfig, Asset, CacheKey, PackageHashes)
+			&& FThumbnailExporterCache::GetThumbnail(CacheKey, Pending->SizeX, Pending->SizeY, Pending->Pixels))
+		{
+			Result.bFromCache = true;
+		}
+	}
+
+	if (!Result.bFromCache)
+	{
+		UObject* Object = nullptr;
+		{
+			SCOPE_THUMBNAIL_EXPORT_STAGE(AssetLoad);
+			Object = Asset.GetAsset();
+		}
+
+		// Blueprints without anything to render would only give a blank thumbnail, don't spend a spawn and a render on them.
+		// Only the visual component spawn is limited to the templates, a full spawn runs the construction script and the
+		// creation delegate can add meshes to the preview actor
+		const UBlueprint* Blueprint = Cast<UBlueprint>(Object);
+		const bool bCanSkipBlueprint = Pending->CreationConfig.bSkipNonVisualBlueprints
+			&& Pending->CreationConfig.BlueprintSpawnMode == EThumbnailBlueprintSpawnMode::VisualComponentsOnly
+			&& !CreationDelegate.IsBound();
+		if (Blueprint && bCanSkipBlueprint && !FThumbnailExporterScene::HasVisualComponentTemplates(Blueprint->GeneratedClass))
+		{
+			UE_LOG(LogThumbnailExporter, Verbose, TEXT("Skipping %s, it has no visible mesh components"), *Asset.GetObjectPathString());
+			Result.Status = EThumbnailExportStatus::Skipped;
+			return nullptr;
+		}
+
+		FThumbnailRenderStats RenderStats;
+		FObjectThumbnail* Thumb = FThumbnailExporterRenderer::GenerateThumbnail(Pending->CreationConfig, Object, CreationDelegate, &RenderStats);
+		if (!Thumb)
+		{
+			return nullptr;
+		}
+		Result.NumTriangles = RenderStats.NumTriangles;
+
+		{
+			SCOPE_THUMBNAIL_EXPORT_STAGE(ImageProcessing);
+
+			Pending->SizeX = Thumb->GetImageWidth();
+			Pending->SizeY = Thumb->GetImageHeight();
+			Pending->Pixels.SetNumUninitialized(Pending->SizeX * Pending->SizeY);
+			FMemory::Memcpy(Pending->Pixels.GetData(), Thumb->GetUncompressedImageData().GetData(), Pending->Pixels.Num() * sizeof(FColor));
+
+			// Cropping a sprite sheet would break up its grid of frames
+			if (Pending->CreationConfig.CropMode != EThumbnailCropMode::None && Pending->CreationConfig.GetNumFrames() == 1)
+			{
+				CropThumbnail(Pending->CreationConfig, Pending->SizeX, Pending->SizeY, Pending->Pixels);
+			}
+
+			// Atlas pages are filled once they've been packed
+			if (GeneratesMips(Pending->CreationConfig) && Pending->CreationConfig.bAlphaAwareMipFiltering && !Pending->CreationConfig.bPackIntoAtlas)
+			{
+				FThumbnailExporterImageUtils::BleedColorIntoTransparentPixels(Pending->Pixels, Pending->SizeX, Pending->SizeY);
+			}
+		}
+
+		// The cache is shared, only real renders may go in it
+		if (!CacheKey.IsEmpty() && RenderStats.bRendered && FApp::CanEverRender())
+		{
+			SCOPE_THUMBNAIL_EXPORT_STAGE(DerivedDataCache);
+			FThumbnailExporterCache::PutThumbnail(CacheKey, Pending->SizeX, Pending->SizeY, Pending->Pixels);
+		}
+	}
+
+	Pending->TrackedMemory = Pending->Pixels.GetAllocatedSize();
+	INC_MEMORY_STAT_BY(STAT_ThumbnailExporter_PendingThumbnailMemory, Pending->TrackedMemory);
+
+	// The pixels aren't touched again until the encode is finished, so the worker can read them directly.
+	// Atlased thumbnails only need the hash, the atlas pages are compressed instead
+	const bool bCompressSource = Pending->CreationConfig.bCompressTextureSource && !Pending->CreationConfig.bPackIntoAtlas;
+	Pending->Encoded = Async(EAsyncExecution::ThreadPool, [Pixels = TArrayView<const FColor>(Pending->Pixels), SizeX = Pending->SizeX, SizeY = Pending->SizeY, CreationConfig = Pending->CreationConfig, bCompressSource]()
+	{
+		return EncodeThumbnail(Pixels, SizeX, SizeY, CreationConfig, bCompressSource);
+	});
+
+	return Pending;
+}
+
+void FThumbnailExporterBatch::WriteThumbnail(FPendingThumbnail& Pending)
+{
+	FThumbnailExportResult& Result = Report.Results[Pending.ResultIndex];
+	const FThumbnailCreationConfig& ModifiedCreationConfig = Pending.CreationConfig;
+
+	TGuardValue<FThumbnailExportStageTimings*> ActiveTimings(FThumbnailExportStageScope::ActiveTimings, &Result.Timings);
+
+	FEncodedThumbnail Encoded;
+	{
+		SCOPE_THUMBNAIL_EXPORT_STAGE(EncodeWait);
+		Encoded = Pending.Encoded.Get();
+	}
+	Result.Timings[EThumbnailExportStage::Encode] += Encoded.EncodeSeconds;
+
+	if (ModifiedCreationConfig.bPackIntoAtlas)
+	{
+		// Hold on to the thumbnail until the whole batch has been rendered and can be packed
+		int32* ExistingImageIndex = ModifiedCreationConfig.bDeduplicateThumbnails ? UniqueAtlasImages.Find(Encoded.Hash) : nullptr;
+		if (ExistingImageIndex)
+		{
+			AtlasImages[*ExistingImageIndex].ResultIndices.Add(Pending.ResultIndex);
+			Result.Status = EThumbnailExportStatus::Deduplicated;
+		}
+		else
+		{
+			FAtlasImage& Image = AtlasImages.AddDefaulted_GetRef();
+			Image.SizeX = Pending.SizeX;
+			Image.SizeY = Pending.SizeY;
+			Image.Pixels = MoveTemp(Pending.Pixels);
+			Image.ResultIndices.Add(Pending.ResultIndex);
+			INC_MEMORY_STAT_BY(STAT_ThumbnailExporter_AtlasImageMemory, Image.Pixels.GetAllocatedSize());
+			UniqueAtlasImages.Add(Encoded.Hash, AtlasImages.Num() - 1);
+			Result.Status = EThumbnailExportStatus::Atlased;
+		}
+		return;
+	}
+
+	if (ModifiedCreationConfig.bDeduplicateThumbnails)
+	{
+		if (const FString* SharedThumbnailPath = UniqueThumbnails.Find(Encoded.Hash))
+		{
+			Result.ThumbnailPath = *SharedThumbnailPath;
+			Result.Status = EThumbnailExportStatus::Deduplicated;
+			Result.bSuccess = true;
+			BroadcastResult(Pending.ResultIndex);
+			return;
+		}
+	}
+
+	Result.Status = WriteThumbnailTexture(ModifiedCreationConfig, Pending.ThumbnailPath, Pending.SizeX, Pending.SizeY, Pending.Pixels, Encoded, Result.StoredSourceBytes);
+	if (Result.Status == EThumbnailExportStatus::Failed)
+	{
+		BroadcastResult(Pending.ResultIndex);
+		return;
+	}
+
+	if (Result.Status != EThumbnailExportStatus::Identical)
+	{
+		Result.RawSourceBytes = Pending.Pixels.Num() * sizeof(FColor);
+	}
+	Result.bSuccess = true;
+	UniqueThumbnails.Add(Encoded.Hash, Pending.ThumbnailPath);
+	BroadcastResult(Pending.ResultIndex);
+}
+
+void FThumbnailExporterBatch::WriteAtlas()
+{
+	SCOPE_THUMBNAIL_EXPORT_STAGE(AtlasPacking);
+
+	if (AtlasImages.Num() == 0)
+	{
+		return;
+	}
+
+	// The pages are named after the manifest, so without one there is nowhere to write them
+	const FString ManifestPackagePath = GetManifestPackagePath();
+	if (ManifestPackagePath.IsEmpty())
+	{
+		UE_LOG(LogThumbnailExporter, Error, TEXT("Can't write the thumbnail atlas, there is no manifest path to name its pages after. Set a manifest path or turn off atlas packing"));
+		for (const FAtlasImage& Image : AtlasImages)
+		{
+			for (int32 ResultIndex : Image.ResultIndices)
+			{
+				Report.Results[ResultIndex].Status = EThumbnailExportStatus::Failed;
+			}
+		}
+		EmptyAtlasImages();
+		return;
+	}
+
+	const int32 AtlasSize = CreationConfig.AtlasSize;
+	FThumbnailExporterAtlasPacker Packer(AtlasSize, AtlasSize, CreationConfig.AtlasPadding);
+
+	// Packing the tallest images first keeps the skyline flat
+	TArray<int32> PackingOrder;
+	for (int32 i = 0; i < AtlasImages.Num(); ++i)
+	{
+		PackingOrder.Add(i);
+	}
+	PackingOrder.Sort([this](int32 A, int32 B) { return AtlasImages[A].SizeY > AtlasImages[B].SizeY; });
+
+	for (int32 ImageIndex : PackingOrder)
+	{
+		FAtlasImage& Image = AtlasImages[ImageIndex];
+		if (!Packer.AddRect(Image.SizeX, Image.SizeY, Image.Page, Image.Position))
+		{
+			UE_LOG(LogThumbnailExporter, Warning, TEXT("Thumbnail of %s (%dx%d) does not fit in a %dx%d atlas page"),
+				*Report.Results[Image.ResultIndices[0]].Asset.GetObjectPathString(), Image.SizeX, Image.SizeY, AtlasSize, AtlasSize);
+			Image.Page = INDEX_NONE;
+		}
+	}
+
+	// Copy the thumbnails into the pages
+	const FColor BackgroundColor = CreationConfig.ThumbnailBackground.ToFColor(true);
+	TArray<TArray<FColor>> Pages;
+	Pages.SetNum(Packer.GetNumPages());
+	for (TArray<FColor>& Page : Pages)
+	{
+		Page.Init(BackgroundColor, AtlasSize * AtlasSize);
+	}
+
+	for (const FAtlasImage& Image : AtlasImages)
+	{
+		if (Image.Page != INDEX_NONE)
+		{
+			TArray<FColor>& Page = Pages[Image.Page];
+			for (int32 Y = 0; Y < Image.SizeY; ++Y)
+			{
+				FMemory::Memcpy(&Page[(Image.Position.Y + Y) * AtlasSize + Image.Position.X], &Image.Pixels[Y * Image.SizeX], Image.SizeX * sizeof(FColor));
+			}
+		}
+	}
+
+	// Fill and encode the pages in parallel
+	TArray<FEncodedThumbnail> EncodedPages;
+	EncodedPages.SetNum(Pages.Num());
+	const bool bBleedColor = GeneratesMips(CreationConfig) && CreationConfig.bAlphaAwareMipFiltering;
+	ParallelFor(Pages.Num(), [this, &Pages, &EncodedPages, AtlasSize, bBleedColor](int32 PageIndex)
+	{
+		if (bBleedColor)
+		{
+			FThumbnailExporterImageUtils::BleedColorIntoTransparentPixels(Pages[PageIndex], AtlasSize, AtlasSize);
+		}
+		EncodedPages[PageIndex] = EncodeThumbnail(Pages[PageIndex], AtlasSize, AtlasSize, CreationConfig, CreationConfig.bCompressTextureSource);
+	});
+
+	TArray<EThumbnailExportStatus> PageStatuses;
+	for (int32 PageIndex = 0; PageIndex < Pages.Num(); ++PageIndex)
+	{
+		const FString PagePath = FString::Printf(TEXT("%s_Atlas%d"), *ManifestPackagePath, PageIndex);
+
+		int64 StoredSourceBytes = 0;
+		const EThumbnailExportStatus PageStatus = WriteThumbnailTexture(CreationConfig, PagePath, AtlasSize, AtlasSize, Pages[PageIndex], EncodedPages[PageIndex], StoredSourceBytes);
+		PageStatuses.Add(PageStatus);
+		Report.AtlasPagePaths.Add(PagePath);
+
+		if (PageStatus == EThumbnailExportStatus::New || PageStatus == EThumbnailExportStatus::Changed)
+		{
+			AtlasRawSourceBytes += Pages[PageIndex].Num() * sizeof(FColor);
+			AtlasStoredSourceBytes += StoredSourceBytes;
+		}
+	}
+
+	for (const FAtlasImage& Image : AtlasImages)
+	{
+		if (Image.Page == INDEX_NONE || PageStatuses[Image.Page] == EThumbnailExportStatus::Failed)
+		{
+			for (int32 ResultIndex : Image.ResultIndices)
+			{
+				Report.Results[ResultIndex].Status = EThumbnailExportStatus::Failed;
+			}
+			continue;
+		}
+
+		for (int32 ResultIndex : Image.ResultIndices)
+		{
+			FThumbnailExportResult& Result = Report.Results[ResultIndex];
+			Result.ThumbnailPath = Report.AtlasPagePaths[Image.Page];
+			Result.AtlasPage = Image.Page;
+			Result.AtlasUVOffset = FVector2D(Image.Position) / AtlasSize;
+			Result.AtlasUVSize = FVector2D(Image.SizeX, Image.SizeY) / AtlasSize;
+			Result.bSuccess = true;
+		}
+	}
+
+	EmptyAtlasImages();
+}
+
+void FThumbnailExporterBatch::EmptyAtlasImages()
+{
+	for (const FAtlasImage& Image : AtlasImages)
+	{
+		DEC_MEMORY_STAT_BY(STAT_ThumbnailExporter_AtlasImageMemory, Image.Pixels.GetAllocatedSize());
+	}
+	AtlasImages.Empty();
+}
+
+void FThumbnailExporterBatch::DeleteStaleAtlasPages()
+{
+	SCOPE_THUMBNAIL_EXPORT_STAGE(AtlasPacking);
+
+	// Pages past the ones just written are left over from an earlier export that needed more of them
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+	TArray<FAssetData> StalePages;
+	for (int32 PageIndex = Report.AtlasPagePaths.Num(); ; ++PageIndex)
+	{
+		const FString PagePath = FString::Printf(TEXT("%s_Atlas%d"), *Report.ManifestPath, PageIndex);
+		TArray<FAssetData> PageAssets;
+		AssetRegistry.GetAssetsByPackageName(*PagePath, PageAssets);
+		if (PageAssets.Num() == 0)
+		{
+			break;
+		}
+		StalePages.Append(PageAssets);
+	}
+
+	if (StalePages.Num() > 0)
+	{
+		UE_LOG(LogThumbnailExporter, Log, TEXT("Deleting %d atlas pages of %s that are no longer used"), StalePages.Num(), *Report.ManifestPath);
+		ObjectTools::DeleteAssets(StalePages, false);
+	}
+}
+
+void FThumbnailExporterBatch::BroadcastResult(int32 ResultIndex) const
+{
+	OnThumbnailExported.ExecuteIfBound(Report.Results[ResultIndex]);
+}
+
+FString FThumbnailExporterBatch::GetManifestPackagePath() const
+{
+	if (!CreationConfig.ManifestPath.Path.IsEmpty())
+	{
+		return CreationConfig.ManifestPath.Path / CreationConfig.ManifestName;
+	}
+
+	// Default to the folder the first thumbnail would be exported to
+	const FThumbnailExportResult* FirstResult = Report.Results.FindByPredicate([](const FThumbnailExportResult& Result) { return !Result.ThumbnailPath.IsEmpty(); });
+	if (FirstResult == nullptr)
+	{
+		return FString();
+	}
+
+	return FPaths::GetPath(FirstResult->ThumbnailPath) / CreationConfig.ManifestName;
+}
+
+void FThumbnailExporterBatch::WriteManifest()
+{
+	SCOPE_THUMBNAIL_EXPORT_STAGE(Manifest);
+
+	if (Report.NumExported == 0)
+	{
+		return;
+	}
+
+	const FString ManifestPackagePath = GetManifestPackagePath();
+	if (ManifestPackagePath.IsEmpty())
+	{
+		return;
+	}
+
+	UPackage* Package = GetAssetPackage(CreationConfig, ManifestPackagePath);
+	if (Package == nullptr)
+	{
+		return;
+	}
+
+	// Add to the existing manifest so separate batches can share one
+	UThumbnailExporterManifest* Manifest = FindObject<UThumbnailExporterManifest>(Package, *CreationConfig.ManifestName);
+	if (Manifest == nullptr)
+	{
+		Manifest = NewObject<UThumbnailExporterManifest>(Package, *CreationConfig.ManifestName, RF_Public | RF_Standalone);
+		FAssetRegistryModule::AssetCreated(Manifest);
+	}
+
+	// The atlas pages were rewritten, so entries pointing into the old pages are no longer valid
+	if (Report.AtlasPagePaths.Num() > 0)
+	{
+		for (auto It = Manifest->Thumbnails.CreateIterator(); It; ++It)
+		{
+			if (It->Value.AtlasPage != INDEX_NONE)
+			{
+				It.RemoveCurrent();
+			}
+		}
+
+		Manifest->AtlasPages.Empty();
+		for (const FString& PagePath : Report.AtlasPagePaths)
+		{
+			Manifest->AtlasPages.Add(TSoftObjectPtr<UTexture2D>(GetThumbnailObjectPath(PagePath)));
+		}
+	}
+
+	for (const FThumbnailExportResult& Result : Report.Results)
+	{
+		if (Result.bSuccess)
+		{
+			FThumbnailManifestEntry& Entry = Manifest->Thumbnails.FindOrAdd(Result.Asset.ToSoftObjectPath());
+			Entry.Texture = TSoftObjectPtr<UTexture2D>(GetThumbnailObjectPath(Result.ThumbnailPath));
+			Entry.AtlasPage = Result.AtlasPage;
+			Entry.UVOffset = Result.AtlasUVOffset;
+			Entry.UVSize = Result.AtlasUVSize;
+			Entry.NumFrames = Result.NumFrames;
+			Entry.NumFrameColumns = Result.NumFrameColumns;
+		}
+	}
+
+	Package->MarkPackageDirty();
+	SaveAssetPackage(Package, Manifest, ManifestPackagePath);
+
+	Report.ManifestPath = ManifestPackagePath;
+}
+
+void FThumbnailExporterBatch::WriteTimingReport()
+{
+	const FString ReportDirectory = FPaths::ProjectSavedDir() / TEXT("ThumbnailExporter") / TEXT("Reports");
+	// Batches can finish within the same millisecond (the queue, single asset exports), so the timestamp alone isn't unique
+	const FString ReportBaseName = ReportDirectory / FString::Printf(TEXT("ThumbnailExport-%s-%s"), *FDateTime::Now().ToString(TEXT("%Y.%m.%d-%H.%M.%S.%s")), *FGuid::NewGuid().ToString(EGuidFormats::Short));
+	IFileManager::Get().MakeDirectory(*ReportDirectory, true);
+
+	const UEnum* StatusEnum = StaticEnum<EThumbnailExportStatus>();
+	const int32 NumStages = (int32)EThumbnailExportStage::Num;
+
+	// CSV: one row per asset, one column per stage, then a row with the batch totals
+	FString Csv = TEXT("Asset,Status,TotalSeconds");
+	for (int32 StageIndex = 0; StageIndex < NumStages; ++StageIndex)
+	{
+		Csv += FString::Printf(TEXT(",%s"), FThumbnailExportStageTimings::GetStageName((EThumbnailExportStage)StageIndex));
+	}
+	Csv += LINE_TERMINATOR;
+
+	auto AddCsvRow = [&Csv, NumStages](const FString& Name, const FString& Status, double TotalSeconds, const FThumbnailExportStageTimings& Timings)
+	{
+		Csv += FString::Printf(TEXT("%s,%s,%f"), *Name, *Status, TotalSeconds);
+		for (int32 StageIndex = 0; StageIndex < NumStages; ++StageIndex)
+		{
+			Csv += FString::Printf(TEXT(",%f"), Timings.Seconds[StageIndex]);
+		}
+		Csv += LINE_TERMINATOR;
+	};
+
+	for (const FThumbnailExportResult& Result : Report.Results)
+	{
+		AddCsvRow(Result.Asset.GetObjectPathString(), StatusEnum->GetNameStringByValue((int64)Result.Status), Result.Timings.GetTotalSeconds(), Result.Timings);
+	}
+	AddCsvRow(TEXT("Batch"), FString(), Report.TotalSeconds, Report.Timings);
+
+	// JSON: the batch totals and counts, then the per asset timings
+	FString Json;
+	TSharedRef<TJsonWriter<>> JsonWriter = TJsonWriterFactory<>::Create(&Json);
+	JsonWriter->WriteObjectStart();
+	JsonWriter->WriteValue(TEXT("NumAssets"), Assets.Num());
+	JsonWriter->WriteValue(TEXT("NumExported"), Report.NumExported);
+	JsonWriter->WriteValue(TEXT("NumFailed"), Report.NumFailed);
+	JsonWriter->WriteValue(TEXT("NumSkipped"), Report.NumSkipped);
+	JsonWriter->WriteValue(TEXT("ThumbnailSize"), CreationConfig.ThumbnailSize);
+	JsonWriter->WriteValue(TEXT("TotalSeconds"), Report.TotalSeconds);
+
+	auto WriteJsonStages = [&JsonWriter, NumStages](const FThumbnailExportStageTimings& Timings)
+	{
+		JsonWriter->WriteObjectStart(TEXT("Stages"));
+		for (int32 StageIndex = 0; StageIndex < NumStages; ++StageIndex)
+		{
+			JsonWriter->WriteValue(FThumbnailExportStageTimings::GetStageName((EThumbnailExportStage)StageIndex), Timings.Seconds[StageIndex]);
+		}
+		JsonWriter->WriteObjectEnd();
+	};
+	WriteJsonStages(Report.Timings);
+
+	JsonWriter->WriteArrayStart(TEXT("Results"));
+	for (const FThumbnailExportResult& Result : Report.Results)
+	{
+		JsonWriter->WriteObjectStart();
+		JsonWriter->WriteValue(TEXT("Asset"), Result.Asset.GetObjectPathString());
+		JsonWriter->WriteValue(TEXT("Status"), StatusEnum->GetNameStringByValue((int64)Result.Status));
+		JsonWriter->WriteValue(TEXT("NumTriangles"), Result.NumTriangles);
+		JsonWriter->WriteValue(TEXT("TotalSeconds"), Result.Timings.GetTotalSeconds());
+		WriteJsonStages(Result.Timings);
+		JsonWriter->WriteObjectEnd();
+	}
+	JsonWriter->WriteArrayEnd();
+	JsonWriter->WriteObjectEnd();
+	JsonWriter->Close();
+
+	const FString CsvPath = ReportBaseName + TEXT(".csv");
+	const FString JsonPath = ReportBaseName + TEXT(".json");
+	if (!FFileHelper::SaveStringToFile(Csv, *CsvPath) || !FFileHelper::SaveStringToFile(Json, *JsonPath))
+	{
+		UE_LOG(LogThumbnailExporter, Warning, TEXT("Failed to write the thumbnail export timing report to %s"), *ReportDirectory);
+		return;
+	}
+
+	Report.TimingReportPath = JsonPath;
+	UE_LOG(LogThumbnailExporter, Log, TEXT("Wrote thumbnail export timing report to %s"), *JsonPath);
+}
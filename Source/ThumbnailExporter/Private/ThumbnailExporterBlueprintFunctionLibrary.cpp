@@ -5,12 +5,21 @@
 
 #include "ThumbnailExporter.h"
 #include "ThumbnailExporterSettings.h"
+#include "ThumbnailExporterAsyncExport.h"
 
 bool UThumbnailExporterBlueprintFunctionLibrary::ExportThumbnail(const FThumbnailCreationConfig& CreationConfig, const FAssetData& Asset, FString& ThumbnailPath, const FPreCreateThumbnail& CreationDelegate)
 {
     return FModuleManager::GetModuleChecked<FThumbnailExporterModule>("ThumbnailExporter").ExportThumbnail(CreationConfig, Asset, ThumbnailPath, CreationDelegate);
 }
 
+UThumbnailExporterAsyncExport* UThumbnailExporterBlueprintFunctionLibrary::StartThumbnailExport(const FThumbnailCreationConfig& CreationConfig, const TArray<FAssetData>& Assets, const FPreCreateThumbnail& CreationDelegate)
+{
+    // Nothing is exported until the queue ticks, so the caller can still bind the delegates
+    UThumbnailExporterAsyncExport* Action = UThumbnailExporterAsyncExport::ExportThumbnailsAsync(CreationConfig, Assets, CreationDelegate);
+    Action->Activate();
+    return Action;
+}
+
 bool UThumbnailExporterBlueprintFunctionLibrary::CanCreateThumbnail(const FAssetData& Asset)
 {
     return FModuleManager::GetModuleChecked<FThumbnailExporterModule>("ThumbnailExporter").CanCreateThumbnail({Asset});
@@ -0,0 +1,207 @@
+// Copyright 2023 Big Cat Energising. All Rights Reserved.
+
+
+#include "ThumbnailExporterCache.h"
+
+#include "ThumbnailExporterSettings.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "DerivedDataCacheInterface.h"
+#include "Interfaces/IPluginManager.h"
+#include "JsonObjectConverter.h"
+#include "Misc/EngineVersion.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+// Bump this if the way thumbnails are rendered or stored in the cache changes
+static const TCHAR* ThumbnailCacheVersion = TEXT("A3C1E2B4-6F0D-4E5A-9C7B-1D2E3F405162");
+
+// Returns true if the package is loaded and has unsaved changes, in which case its saved hash doesn't describe it anymore
+static bool IsPackageDirty(FName PackageName)
+{
+	const UPackage* Package = FindPackage(nullptr, *PackageName.ToString());
+	return Package != nullptr && Package->IsDirty();
+}
+
+// Returns a copy of the config with the settings that don't change the cached pixels reset to their defaults, so exports that
+// only differ in where and how the texture is saved share cache entries
+static FThumbnailCreationConfig GetRenderingConfig(const FThumbnailCreationConfig& CreationConfig)
+{
+	const FThumbnailCreationConfig DefaultConfig;
+	FThumbnailCreationConfig RenderingConfig = CreationConfig;
+
+	// Naming and output paths
+	RenderingConfig.bOverrideThumbnailPath = DefaultConfig.bOverrideThumbnailPath;
+	RenderingConfig.ThumbnailOverridePath = DefaultConfig.ThumbnailOverridePath;
+	RenderingConfig.bOverrideThumbnailFilename = DefaultConfig.bOverrideThumbnailFilename;
+	RenderingConfig.ThumbnailOverrideFilename = DefaultConfig.ThumbnailOverrideFilename;
+	RenderingConfig.ThumbnailPrefix = DefaultConfig.ThumbnailPrefix;
+	RenderingConfig.ThumbnailSuffix = DefaultConfig.ThumbnailSuffix;
+	RenderingConfig.ManifestPath = DefaultConfig.ManifestPath;
+	RenderingConfig.ManifestName = DefaultConfig.ManifestName;
+
+	// Applied to the texture once the pixels are cached. The texture group, mip settings and atlas packing stay, they decide whether colors are bled into transparent pixels
+	RenderingConfig.ThumbnailCompressionSettings = DefaultConfig.ThumbnailCompressionSettings;
+	RenderingConfig.bStreamable = DefaultConfig.bStreamable;
+	RenderingConfig.bCompressTextureSource = DefaultConfig.bCompressTextureSource;
+	RenderingConfig.AtlasSize = DefaultConfig.AtlasSize;
+	RenderingConfig.AtlasPadding = DefaultConfig.AtlasPadding;
+
+	// How the batch runs and reports
+	RenderingConfig.bSkipNonVisualBlueprints = DefaultConfig.bSkipNonVisualBlueprints;
+	RenderingConfig.bSkipUnchangedThumbnails = DefaultConfig.bSkipUnchangedThumbnails;
+	RenderingConfig.bDeduplicateThumbnails = DefaultConfig.bDeduplicateThumbnails;
+	RenderingConfig.bUseDerivedDataCache = DefaultConfig.bUseDerivedDataCache;
+	RenderingConfig.bWriteTimingReport = DefaultConfig.bWriteTimingReport;
+	RenderingConfig.bCreateThumbnailNotification = DefaultConfig.bCreateThumbnailNotification;
+
+	return RenderingConfig;
+}
+
+// Returns the saved hash and hard dependencies of the package, asking the asset registry the first time only
+static const FThumbnailExporterCache::FPackageHashes::FPackageInfo& GetPackageInfo(IAssetRegistry& AssetRegistry, FThumbnailExporterCache::FPackageHashes& PackageHashes, FName PackageName)
+{
+	if (const FThumbnailExporterCache::FPackageHashes::FPackageInfo* PackageInfo = PackageHashes.Packages.Find(PackageName))
+	{
+		return *PackageInfo;
+	}
+
+	FThumbnailExporterCache::FPackageHashes::FPackageInfo PackageInfo;
+
+	const TOptional<FAssetPackageData> PackageData = AssetRegistry.GetAssetPackageDataCopy(PackageName);
+	if (PackageData.IsSet())
+	{
+		PackageInfo.SavedHash = LexToString(PackageData->GetPackageSavedHash());
+	}
+
+	TArray<FName> Dependencies;
+	AssetRegistry.GetDependencies(PackageName, Dependencies, UE::AssetRegistry::EDependencyCategory::Package, UE::AssetRegistry::EDependencyQuery::Hard);
+	for (FName Dependency : Dependencies)
+	{
+		if (!FPackageName::IsScriptPackage(Dependency.ToString()))
+		{
+			PackageInfo.HardDependencies.Add(Dependency);
+		}
+	}
+
+	return PackageHashes.Packages.Add(PackageName, MoveTemp(PackageInfo));
+}
+
+bool FThumbnailExporterCache::GetCacheKey(const FThumbnailCreationConfig& CreationConfig, const FAssetData& Asset, FString& OutCacheKey, FPackageHashes& PackageHashes)
+{
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+
+	// Gather the asset's package and everything it hard depends on. Script packages are covered by the engine and plugin versions
+	TArray<FName> Packages;
+	TSet<FName> VisitedPackages;
+	Packages.Add(Asset.PackageName);
+	VisitedPackages.Add(Asset.PackageName);
+
+	// The flipbook animation and variant materials aren't dependencies of the asset, but change what is rendered just the same
+	TArray<FSoftObjectPath> ConfigAssets;
+	ConfigAssets.Add(CreationConfig.FlipbookAnimation.ToSoftObjectPath());
+	for (const FThumbnailMaterialVariant& Variant : CreationConfig.MaterialVariants)
+	{
+		for (const TSoftObjectPtr<UMaterialInterface>& Material : Variant.Materials)
+		{
+			ConfigAssets.Add(Material.ToSoftObjectPath());
+		}
+	}
+
+	for (const FSoftObjectPath& ConfigAsset : ConfigAssets)
+	{
+		const FName ConfigPackageName = ConfigAsset.IsNull() ? NAME_None : FName(*ConfigAsset.GetLongPackageName());
+		if (!ConfigPackageName.IsNone() && !VisitedPackages.Contains(ConfigPackageName))
+		{
+			Packages.Add(ConfigPackageName);
+			VisitedPackages.Add(ConfigPackageName);
+		}
+	}
+	for (int32 PackageIndex = 0; PackageIndex < Packages.Num(); ++PackageIndex)
+	{
+		for (FName Dependency : GetPackageInfo(AssetRegistry, PackageHashes, Packages[PackageIndex]).HardDependencies)
+		{
+			if (!VisitedPackages.Contains(Dependency))
+			{
+				VisitedPackages.Add(Dependency);
+				Packages.Add(Dependency);
+			}
+		}
+	}
+
+	// The first package is always the asset's own, the dependencies are sorted so the key doesn't depend on the order the registry returns them in
+	Packages.RemoveAt(0);
+	Packages.Sort(FNameLexicalLess());
+	Packages.Insert(Asset.PackageName, 0);
+
+	FString KeySource;
+	for (FName PackageName : Packages)
+	{
+		if (IsPackageDirty(PackageName))
+		{
+			return false;
+		}
+
+		const TOptional<FString>& SavedHash = GetPackageInfo(AssetRegistry, PackageHashes, PackageName).SavedHash;
+		if (!SavedHash.IsSet())
+		{
+			// Never been saved, so there is nothing to identify its content by
+			return false;
+		}
+
+		KeySource += PackageName.ToString();
+		KeySource += SavedHash.GetValue();
+	}
+
+	FString ConfigJson;
+	if (!FJsonObjectConverter::UStructToJsonObjectString(GetRenderingConfig(CreationConfig), ConfigJson))
+	{
+		return false;
+	}
+	KeySource += ConfigJson;
+
+	const TSharedPtr<IPlugin> Plugin = IPluginManager::Get().FindPlugin(TEXT("ThumbnailExporter"));
+	if (Plugin.IsValid())
+	{
+		KeySource += Plugin->GetDescriptor().VersionName;
+	}
+	KeySource += FEngineVersion::Current().ToString();
+
+	// The full key source is far too long to be a key, so use its hash
+	FSHAHash KeyHash;
+	FSHA1::HashBuffer(*KeySource, KeySource.Len() * sizeof(TCHAR), KeyHash.Hash);
+
+	OutCacheKey = FDerivedDataCacheInterface::BuildCacheKey(TEXT("THUMBNAILEXPORTER"), ThumbnailCacheVersion, *KeyHash.ToString());
+	return true;
+}
+
+bool FThumbnailExporterCache::GetThumbnail(const FString& CacheKey, int32& OutSizeX, int32& OutSizeY, TArray<FColor>& OutPixels)
+{
+	TArray<uint8> Data;
+	if (!GetDerivedDataCacheRef().GetSynchronous(*CacheKey, Data, TEXT("ThumbnailExporter")))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(Data);
+	Reader << OutSizeX;
+	Reader << OutSizeY;
+	Reader << OutPixels;
+
+	return !Reader.IsError() && OutSizeX > 0 && OutSizeY > 0 && OutPixels.Num() == OutSizeX * OutSizeY;
+}
+
+void FThumbnailExporterCache::PutThumbnail(const FString& CacheKey, int32 SizeX, int32 SizeY, TArrayView<const FColor> Pixels)
+{
+	TArray<uint8> Data;
+	Data.Reserve(Pixels.Num() * sizeof(FColor) + 16);
+
+	FMemoryWriter Writer(Data);
+	Writer << SizeX;
+	Writer << SizeY;
+
+	int32 NumPixels = Pixels.Num();
+	Writer << NumPixels;
+	Writer.Serialize(const_cast<FColor*>(Pixels.GetData()), NumPixels * sizeof(FColor));
+
+	GetDerivedDataCacheRef().Put(*CacheKey, Data, TEXT("ThumbnailExporter"));
+}
@@ -0,0 +1,219 @@
+// Copyright 2023 Big Cat Energising. All Rights Reserved.
+
+
+#include "ThumbnailExporterImageUtils.h"
+#include "Math/VectorRegister.h"
+
+void FThumbnailExporterImageUtils::BleedColorIntoTransparentPixels(TArrayView<FColor> Pixels, int32 SizeX, int32 SizeY)
+{
+	check(Pixels.Num() == SizeX * SizeY);
+
+	// Each level stores the alpha weighted color sum in RGB and the total weight in A
+	struct FLevel
+	{
+		int32 SizeX;
+		int32 SizeY;
+		TArray<FLinearColor> Texels;
+	};
+
+	TArray<FLevel> Levels;
+	{
+		FLevel& Base = Levels.AddDefaulted_GetRef();
+		Base.SizeX = SizeX;
+		Base.SizeY = SizeY;
+		Base.Texels.SetNumUninitialized(Pixels.Num());
+
+		bool bHasTransparentPixels = false;
+		bool bHasVisiblePixels = false;
+		for (int32 i = 0; i < Pixels.Num(); ++i)
+		{
+			const FColor& Pixel = Pixels[i];
+			const float Weight = Pixel.A / 255.f;
+			Base.Texels[i] = FLinearColor(Pixel.R * Weight, Pixel.G * Weight, Pixel.B * Weight, Weight);
+
+			bHasTransparentPixels |= Pixel.A == 0;
+			bHasVisiblePixels |= Pixel.A != 0;
+		}
+
+		// Nothing to fill, or nothing to fill it with
+		if (!bHasTransparentPixels || !bHasVisiblePixels)
+		{
+			return;
+		}
+	}
+
+	// Pull: build a pyramid of weighted color sums down to a single texel
+	while (Levels.Last().SizeX > 1 || Levels.Last().SizeY > 1)
+	{
+		const int32 FineIndex = Levels.Num() - 1;
+		const int32 FineSizeX = Levels[FineIndex].SizeX;
+		const int32 FineSizeY = Levels[FineIndex].SizeY;
+
+		FLevel& Coarse = Levels.AddDefaulted_GetRef();
+		Coarse.SizeX = (FineSizeX + 1) / 2;
+		Coarse.SizeY = (FineSizeY + 1) / 2;
+		Coarse.Texels.SetNumZeroed(Coarse.SizeX * Coarse.SizeY);
+
+		const TArray<FLinearColor>& FineTexels = Levels[FineIndex].Texels;
+		for (int32 Y = 0; Y < FineSizeY; ++Y)
+		{
+			for (int32 X = 0; X < FineSizeX; ++X)
+			{
+				Coarse.Texels[(Y / 2) * Coarse.SizeX + (X / 2)] += FineTexels[Y * FineSizeX + X];
+			}
+		}
+	}
+
+	// Push: fill the empty texels of each level from the level above it.
+	// Filled texels are stored normalized with a weight of 1
+	for (int32 LevelIndex = Levels.Num() - 2; LevelIndex >= 0; --LevelIndex)
+	{
+		FLevel& Fine = Levels[LevelIndex];
+		const FLevel& Coarse = Levels[LevelIndex + 1];
+
+		for (int32 Y = 0; Y < Fine.SizeY; ++Y)
+		{
+			for (int32 X = 0; X < Fine.SizeX; ++X)
+			{
+				FLinearColor& Texel = Fine.Texels[Y * Fine.SizeX + X];
+				if (Texel.A <= 0.f)
+				{
+					const FLinearColor& Parent = Coarse.Texels[(Y / 2) * Coarse.SizeX + (X / 2)];
+					Texel = FLinearColor(Parent.R / Parent.A, Parent.G / Parent.A, Parent.B / Parent.A, 1.f);
+				}
+			}
+		}
+	}
+
+	const TArray<FLinearColor>& BaseTexels = Levels[0].Texels;
+	for (int32 i = 0; i < Pixels.Num(); ++i)
+	{
+		FColor& Pixel = Pixels[i];
+		if (Pixel.A == 0)
+		{
+			const FLinearColor& Texel = BaseTexels[i];
+			Pixel.R = (uint8)FMath::Clamp(FMath::RoundToInt(Texel.R / Texel.A), 0, 255);
+			Pixel.G = (uint8)FMath::Clamp(FMath::RoundToInt(Texel.G / Texel.A), 0, 255);
+			Pixel.B = (uint8)FMath::Clamp(FMath::RoundToInt(Texel.B / Texel.A), 0, 255);
+		}
+	}
+}
+
+// Returns a 4 bit mask of which of the 4 pixels starting at Pixels have an alpha above the threshold
+static FORCEINLINE int32 GetOpaqueMask4(const FColor* Pixels, const VectorRegister4Int& Threshold)
+{
+	// FColor is BGRA in memory, so alpha is the top byte of each 32 bit lane
+	const VectorRegister4Int Alpha = VectorShiftRightImmLogical(VectorIntLoad(Pixels), 24);
+	return VectorMaskBits(VectorCastIntToFloat(VectorIntCompareGT(Alpha, Threshold)));
+}
+
+static int32 FindFirstOpaquePixel(const FColor* Row, int32 SizeX, uint8 AlphaThreshold, const VectorRegister4Int& Threshold)
+{
+	int32 X = 0;
+	for (; X + 4 <= SizeX; X += 4)
+	{
+		const int32 Mask = GetOpaqueMask4(Row + X, Threshold);
+		if (Mask != 0)
+		{
+			return X + FMath::CountTrailingZeros((uint32)Mask);
+		}
+	}
+
+	for (; X < SizeX; ++X)
+	{
+		if (Row[X].A > AlphaThreshold)
+		{
+			return X;
+		}
+	}
+
+	return INDEX_NONE;
+}
+
+static int32 FindLastOpaquePixel(const FColor* Row, int32 SizeX, int32 MinX, uint8 AlphaThreshold, const VectorRegister4Int& Threshold)
+{
+	// Check the pixels that don't fill a whole vector first, so the vector loop lines up with the start of the row
+	int32 X = SizeX;
+	for (; (X & 3) != 0 && X > MinX; --X)
+	{
+		if (Row[X - 1].A > AlphaThreshold)
+		{
+			return X - 1;
+		}
+	}
+
+	for (; X - 4 >= MinX; X -= 4)
+	{
+		const int32 Mask = GetOpaqueMask4(Row + X - 4, Threshold);
+		if (Mask != 0)
+		{
+			return X - 4 + FMath::FloorLog2((uint32)Mask);
+		}
+	}
+
+	for (; X > MinX; --X)
+	{
+		if (Row[X - 1].A > AlphaThreshold)
+		{
+			return X - 1;
+		}
+	}
+
+	return INDEX_NONE;
+}
+
+bool FThumbnailExporterImageUtils::FindOpaqueBounds(TArrayView<const FColor> Pixels, int32 SizeX, int32 SizeY, uint8 AlphaThreshold, FIntRect& OutBounds)
+{
+	check(Pixels.Num() == SizeX * SizeY);
+
+	const VectorRegister4Int Threshold = VectorIntSet1(AlphaThreshold);
+
+	int32 MinX = SizeX;
+	int32 MaxX = -1;
+	int32 MinY = SizeY;
+	int32 MaxY = -1;
+
+	for (int32 Y = 0; Y < SizeY; ++Y)
+	{
+		const FColor* Row = Pixels.GetData() + Y * SizeX;
+
+		const int32 FirstOpaque = FindFirstOpaquePixel(Row, SizeX, AlphaThreshold, Threshold);
+		if (FirstOpaque == INDEX_NONE)
+		{
+			continue;
+		}
+
+		// Only the part of the row to the right of the current bounds can still grow them
+		const int32 LastOpaque = FindLastOpaquePixel(Row, SizeX, FMath::Max(FirstOpaque, MaxX + 1), AlphaThreshold, Threshold);
+
+		MinX = FMath::Min(MinX, FirstOpaque);
+		MaxX = FMath::Max(MaxX, LastOpaque != INDEX_NONE ? LastOpaque : FirstOpaque);
+		MinY = FMath::Min(MinY, Y);
+		MaxY = Y;
+	}
+
+	if (MaxY < 0)
+	{
+		return false;
+	}
+
+	OutBounds = FIntRect(MinX, MinY, MaxX + 1, MaxY + 1);
+	return true;
+}
+
+TArray<FColor> FThumbnailExporterImageUtils::CropImage(TArrayView<const FColor> Pixels, int32 SizeX, int32 SizeY, const FIntRect& Rect)
+{
+	check(Rect.Min.X >= 0 && Rect.Min.Y >= 0 && Rect.Max.X <= SizeX && Rect.Max.Y <= SizeY);
+
+	const int32 CroppedSizeX = Rect.Width();
+	const int32 CroppedSizeY = Rect.Height();
+
+	TArray<FColor> CroppedPixels;
+	CroppedPixels.SetNumUninitialized(CroppedSizeX * CroppedSizeY);
+	for (int32 Y = 0; Y < CroppedSizeY; ++Y)
+	{
+		FMemory::Memcpy(&CroppedPixels[Y * CroppedSizeX], &Pixels[(Rect.Min.Y + Y) * SizeX + Rect.Min.X], CroppedSizeX * sizeof(FColor));
+	}
+
+	return CroppedPixels;
+}
@@ -0,0 +1,213 @@
+// Copyright 2023 Big Cat Energising. All Rights Reserved.
+
+
+#include "ThumbnailExporterQueue.h"
+
+#include "ThumbnailExporter.h"
+#include "ThumbnailExporterSettings.h"
+#include "Widgets/Notifications/SNotificationList.h"
+#include "Framework/Notifications/NotificationManager.h"
+
+#define LOCTEXT_NAMESPACE "FThumbnailExporterQueue"
+
+FThumbnailExporterQueue::FThumbnailExporterQueue()
+{
+
+}
+
+FThumbnailExporterQueue::~FThumbnailExporterQueue()
+{
+	CloseNotification();
+}
+
+int32 FThumbnailExporterQueue::Submit(const FThumbnailCreationConfig& CreationConfig, const TArray<FAssetData>& Assets, const FPreCreateThumbnail& CreationDelegate, const FOnThumbnailExported& OnThumbnailExported, const FOnThumbnailExportJobFinished& OnFinished)
+{
+	FJob& Job = Jobs.AddDefaulted_GetRef();
+	Job.Id = NextJobId++;
+	Job.Batch = MakeUnique<FThumbnailExporterBatch>(CreationConfig, Assets, CreationDelegate, OnThumbnailExported);
+	Job.OnFinished = OnFinished;
+
+	NumQueuedAssets += Assets.Num();
+	UpdateNotification();
+
+	return Job.Id;
+}
+
+bool FThumbnailExporterQueue::Cancel(int32 JobId)
+{
+	const int32 JobIndex = Jobs.IndexOfByPredicate([JobId](const FJob& Job) { return Job.Id == JobId; });
+	if (JobIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	Jobs[JobIndex].Batch->Cancel();
+	FinishJob(JobIndex);
+	UpdateNotification();
+	return true;
+}
+
+void FThumbnailExporterQueue::CancelAll()
+{
+	while (Jobs.Num() > 0)
+	{
+		Jobs.Last().Batch->Cancel();
+		FinishJob(Jobs.Num() - 1);
+	}
+	UpdateNotification();
+}
+
+void FThumbnailExporterQueue::SetPaused(bool bInPaused)
+{
+	bPaused = bInPaused;
+	UpdateNotification();
+}
+
+int32 FThumbnailExporterQueue::GetNumRemainingAssets() const
+{
+	int32 NumRemainingAssets = 0;
+	for (const FJob& Job : Jobs)
+	{
+		NumRemainingAssets += Job.Batch->GetNumAssets() - Job.Batch->GetNumProcessed();
+	}
+	return NumRemainingAssets;
+}
+
+void FThumbnailExporterQueue::Tick(float DeltaTime)
+{
+	if (bPaused || Jobs.Num() == 0)
+	{
+		return;
+	}
+
+	ActiveSeconds += DeltaTime;
+
+	// Export at least one thumbnail per tick, then keep going until the budget is used up
+	const double TimeBudget = UThumbnailExporterSettings::Get()->ExportQueueTimeBudgetMs / 1000.0;
+	const double StartTime = FPlatformTime::Seconds();
+	do
+	{
+		FJob& Job = Jobs[0];
+		Job.Batch->ExportNext();
+		if (Job.Batch->IsFinished())
+		{
+			FinishJob(0);
+		}
+	}
+	while (Jobs.Num() > 0 && !bPaused && FPlatformTime::Seconds() - StartTime < TimeBudget);
+
+	UpdateNotification();
+}
+
+TStatId FThumbnailExporterQueue::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(FThumbnailExporterQueue, STATGROUP_ThumbnailExporter);
+}
+
+void FThumbnailExporterQueue::FinishJob(int32 JobIndex)
+{
+	FJob Job = MoveTemp(Jobs[JobIndex]);
+	Jobs.RemoveAt(JobIndex);
+
+	const FThumbnailExportBatchReport& Report = Job.Batch->GetReport();
+	NumExportedAssets += Report.NumExported;
+	NumFailedAssets += Report.NumFailed;
+	NumSkippedAssets += Report.NumSkipped;
+	NumCancelledAssets += Report.NumCancelled;
+
+	// The job is out of the queue before the callback runs, so the callback can submit more jobs
+	Job.OnFinished.ExecuteIfBound(Report);
+}
+
+void FThumbnailExporterQueue::UpdateNotification()
+{
+	if (Jobs.Num() == 0)
+	{
+		CloseNotification();
+		return;
+	}
+
+	if (!Notification.IsValid())
+	{
+		FNotificationInfo NotificationInfo(FText::GetEmpty());
+		NotificationInfo.bFireAndForget = false;
+
+		// The notification can outlive the queue while it fades out, so the buttons check the queue is still alive first
+		const TWeakPtr<bool> WeakAliveToken = AliveToken;
+		NotificationInfo.ButtonDetails.Add(FNotificationButtonInfo(
+			LOCTEXT("PauseResume", "Pause / Resume"),
+			LOCTEXT("PauseResumeTooltip", "Pauses or resumes the thumbnail export"),
+			FSimpleDelegate::CreateLambda([this, WeakAliveToken]()
+			{
+				if (WeakAliveToken.IsValid())
+				{
+					SetPaused(!bPaused);
+				}
+			}),
+			SNotificationItem::CS_Pending));
+		NotificationInfo.ButtonDetails.Add(FNotificationButtonInfo(
+			LOCTEXT("Cancel", "Cancel"),
+			LOCTEXT("CancelTooltip", "Cancels the remaining thumbnail exports. Thumbnails that were already rendered are still saved"),
+			FSimpleDelegate::CreateLambda([this, WeakAliveToken]()
+			{
+				if (WeakAliveToken.IsValid())
+				{
+					CancelAll();
+				}
+			}),
+			SNotificationItem::CS_Pending));
+
+		Notification = FSlateNotificationManager::Get().AddNotification(NotificationInfo);
+		if (!Notification.IsValid())
+		{
+			return;
+		}
+		Notification->SetCompletionState(SNotificationItem::CS_Pending);
+	}
+
+	// Cancelled assets are neither done nor remaining
+	const int32 NumRemainingAssets = GetNumRemainingAssets();
+	const int32 NumTotalAssets = NumQueuedAssets - NumCancelledAssets;
+	const int32 NumProcessedAssets = NumTotalAssets - NumRemainingAssets;
+
+	FText StatusText;
+	if (bPaused)
+	{
+		StatusText = LOCTEXT("Paused", "Paused");
+	}
+	else if (NumProcessedAssets > 0 && ActiveSeconds > 0.0)
+	{
+		const double ThumbnailsPerSecond = NumProcessedAssets / ActiveSeconds;
+		StatusText = FText::Format(LOCTEXT("Throughput", "{0} per second, {1} remaining"),
+			FText::AsNumber(ThumbnailsPerSecond, &FNumberFormattingOptions::DefaultNoGrouping().SetMaximumFractionalDigits(1)),
+			FText::AsTimespan(FTimespan::FromSeconds(FMath::CeilToDouble(NumRemainingAssets / ThumbnailsPerSecond))));
+	}
+	else
+	{
+		StatusText = LOCTEXT("Estimating", "Estimating time remaining...");
+	}
+
+	Notification->SetText(FText::Format(LOCTEXT("Progress", "Exporting thumbnails: {0} / {1}\n{2}"),
+		FText::AsNumber(NumProcessedAssets), FText::AsNumber(NumTotalAssets), StatusText));
+}
+
+void FThumbnailExporterQueue::CloseNotification()
+{
+	if (Notification.IsValid())
+	{
+		Notification->SetText(FText::Format(LOCTEXT("Finished", "Exported {0} thumbnails ({1} failed, {2} skipped, {3} cancelled)"),
+			FText::AsNumber(NumExportedAssets), FText::AsNumber(NumFailedAssets), FText::AsNumber(NumSkippedAssets), FText::AsNumber(NumCancelledAssets)));
+		Notification->SetCompletionState(NumFailedAssets > 0 ? SNotificationItem::CS_Fail : SNotificationItem::CS_Success);
+		Notification->ExpireAndFadeout();
+		Notification.Reset();
+	}
+
+	NumQueuedAssets = 0;
+	NumExportedAssets = 0;
+	NumFailedAssets = 0;
+	NumSkippedAssets = 0;
+	NumCancelledAssets = 0;
+	ActiveSeconds = 0.0;
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -2,7 +2,9 @@
 
 
 #include "ThumbnailExporterRenderer.h"
+#include "ThumbnailExporter.h"
 #include "ThumbnailExporterSettings.h"
+#include "ThumbnailExporterStats.h"
 #include "Editor/UnrealEdEngine.h"
 #include "UnrealEdGlobals.h"
 #include "TextureCompiler.h"
@@ -13,6 +15,8 @@
 #include "CanvasTypes.h"
 #include "ShaderCompiler.h"
 #include "ContentStreaming.h"
+#include "MaterialShared.h"
+#include "Materials/MaterialInterface.h"
 #include "ThumbnailExporterThumbnailDummy.h"
 #include "BlueprintThumbnailExporterRenderer.h"
 
@@ -37,15 +41,46 @@ static void TransitionAndCopyTexture(FRHICommandList& RHICmdList, FRHITexture* S
 }
 #endif
 
-FObjectThumbnail* FThumbnailExporterRenderer::GenerateThumbnail(FThumbnailCreationConfig& CreationConfig, UObject* InObject, const FPreCreateThumbnail& CreationDelegate)
+bool FThumbnailExporterRenderer::bFillThumbnailsWithoutRenderer = false;
+
+void FThumbnailExporterRenderer::CopyFrames(TArray<uint8>& ImageData, int32 ImageWidth, const TArray<FThumbnailFrameCopy>& FrameCopies)
 {
+	FColor* Pixels = (FColor*)ImageData.GetData();
+	for (const FThumbnailFrameCopy& FrameCopy : FrameCopies)
+	{
+		for (int32 Row = 0; Row < FrameCopy.Size.Y; ++Row)
+		{
+			const FColor* SourceRow = Pixels + (FrameCopy.SourcePosition.Y + Row) * ImageWidth + FrameCopy.SourcePosition.X;
+			FColor* DestRow = Pixels + (FrameCopy.DestPosition.Y + Row) * ImageWidth + FrameCopy.DestPosition.X;
+			FMemory::Memcpy(DestRow, SourceRow, FrameCopy.Size.X * sizeof(FColor));
+		}
+	}
+}
+
+FObjectThumbnail* FThumbnailExporterRenderer::GenerateThumbnail(FThumbnailCreationConfig& CreationConfig, UObject* InObject, const FPreCreateThumbnail& CreationDelegate, FThumbnailRenderStats* OutStats)
+{
+	if (!FApp::CanEverRender() && !bFillThumbnailsWithoutRenderer)
+	{
+		UE_LOG(LogThumbnailExporter, Warning, TEXT("Can't export the thumbnail of %s, there is no renderer (-nullrhi)"), *GetNameSafe(InObject));
+		return nullptr;
+	}
+
 	// Does the object support thumbnails?
 	FThumbnailRenderingInfo* RenderInfo = GUnrealEd ? GUnrealEd->GetThumbnailManager()->GetRenderingInfo(UThumbnailExporterThumbnailDummy::StaticClass()->ClassDefaultObject) : nullptr;
 	if (RenderInfo != NULL && RenderInfo->Renderer != nullptr)
 	{
-		// Set the size of cached thumbnails
-		const int32 ImageWidth = CreationConfig.ThumbnailSize;
-		const int32 ImageHeight = CreationConfig.ThumbnailSize;
+		// Set the size of cached thumbnails. Multi-frame thumbnails render every frame into one sprite sheet
+		const FIntPoint RenderSize = CreationConfig.GetRenderSize();
+		const int32 MaxTextureDimension = (int32)GetMax2DTextureDimension();
+		if (RenderSize.X > MaxTextureDimension || RenderSize.Y > MaxTextureDimension)
+		{
+			UE_LOG(LogThumbnailExporter, Error, TEXT("Can't export the thumbnail of %s, %d frames of %d pixels make a %dx%d sprite sheet, the largest texture the RHI supports is %d. Lower the thumbnail size or the number of frames"),
+				*GetNameSafe(InObject), CreationConfig.GetNumFrames(), CreationConfig.ThumbnailSize, RenderSize.X, RenderSize.Y, MaxTextureDimension);
+			return nullptr;
+		}
+
+		const int32 ImageWidth = RenderSize.X;
+		const int32 ImageHeight = RenderSize.Y;
 
 		// For cached thumbnails we want to make sure that textures are fully streamed in so that the thumbnail we're saving won't have artifacts
 		// However, this can add 30s - 100s to editor load
@@ -56,8 +91,9 @@ FObjectThumbnail* FThumbnailExporterRenderer::GenerateThumbnail(FThumbnailCreati
 		FObjectThumbnail NewThumbnail;
 		FThumbnailExporterRenderer::RenderThumbnail(
 			CreationConfig, InObject, ImageWidth, ImageHeight, TextureFlushMode,
-			&NewThumbnail, CreationDelegate);
+			&NewThumbnail, CreationDelegate, OutStats);
 
+		// Readback is timed inside RenderThumbnail, caching the thumbnail on the package isn't part of any stage
 		UPackage* MyOutermostPackage = InObject->GetOutermost();
 		return ThumbnailTools::CacheThumbnail(InObject->GetFullName(), &NewThumbnail, MyOutermostPackage);
 	}
@@ -74,6 +110,8 @@ struct FThumbnailRenderTargetResource
 
 static FThumbnailRenderTargetResource CreateThumbnailRenderTarget(uint32 InImageWidth, uint32 InImageHeight, FLinearColor ClearColor)
 {
+	SCOPE_THUMBNAIL_EXPORT_STAGE(SceneSetup);
+
 	const uint32 MinRenderTargetSize = FMath::Max(InImageWidth, InImageHeight);
 	UTextureRenderTarget2D* RenderTargetTexture = NewObject<UTextureRenderTarget2D>(GetTransientPackage(), NAME_None, RF_Transient);
 	check(RenderTargetTexture != NULL);
@@ -99,11 +137,66 @@ static FThumbnailRenderTargetResource CreateThumbnailRenderTarget(uint32 InImage
 	return FThumbnailRenderTargetResource{ RenderTargetTexture, RenderTargetResource, MoveTemp(Canvas)};
 }
 
+// Waits for the shaders of the materials to finish compiling, so they don't render with the default material
+static void FinishShaderCompilation(const TArray<UMaterialInterface*>& Materials)
+{
+	SCOPE_THUMBNAIL_EXPORT_STAGE(ShaderCompile);
+	for (UMaterialInterface* Material : Materials)
+	{
+		if (FMaterialResource* MaterialResource = Material->GetMaterialResource(GMaxRHIFeatureLevel))
+		{
+			MaterialResource->FinishCompilation();
+		}
+	}
+}
+
+// Loads the materials of every material variant and waits for their shaders, so swapping variants while rendering never stalls on a compile.
+// Loading them all first lets their shaders compile in parallel
+static void PrewarmMaterialVariants(const FThumbnailCreationConfig& CreationConfig)
+{
+	TArray<UMaterialInterface*> Materials;
+	{
+		SCOPE_THUMBNAIL_EXPORT_STAGE(AssetLoad);
+		for (const FThumbnailMaterialVariant& Variant : CreationConfig.MaterialVariants)
+		{
+			for (const TSoftObjectPtr<UMaterialInterface>& Material : Variant.Materials)
+			{
+				if (UMaterialInterface* LoadedMaterial = Material.LoadSynchronous())
+				{
+					Materials.AddUnique(LoadedMaterial);
+				}
+			}
+		}
+	}
+
+	FinishShaderCompilation(Materials);
+
+	// Have the variants' textures streamed in along with the rest of the scene, even though they aren't on any component yet
+	for (UMaterialInterface* Material : Materials)
+	{
+		Material->SetForceMipLevelsToBeResident(false, false, 30.f);
+	}
+}
+
 void FThumbnailExporterRenderer::RenderThumbnail(FThumbnailCreationConfig& CreationConfig, UObject* InObject, 
-	const uint32 InImageWidth, const uint32 InImageHeight, ThumbnailTools::EThumbnailTextureFlushMode::Type InFlushMode, FObjectThumbnail* OutThumbnail, const FPreCreateThumbnail& CreationDelegate)
+	const uint32 InImageWidth, const uint32 InImageHeight, ThumbnailTools::EThumbnailTextureFlushMode::Type InFlushMode, FObjectThumbnail* OutThumbnail, const FPreCreateThumbnail& CreationDelegate, FThumbnailRenderStats* OutStats)
 {
 	if (!FApp::CanEverRender())
 	{
+		// Without a renderer (-nullrhi), the benchmark gets a thumbnail filled with the background color so the CPU side of the export still runs
+		if (OutThumbnail && bFillThumbnailsWithoutRenderer)
+		{
+			OutThumbnail->SetImageSize(InImageWidth, InImageHeight);
+
+			TArray<uint8>& OutData = OutThumbnail->AccessImageData();
+			OutData.SetNumUninitialized(InImageWidth * InImageHeight * sizeof(FColor));
+
+			const FColor BackgroundColor = CreationConfig.ThumbnailBackground.ToFColor(true);
+			for (FColor* Color = (FColor*)OutData.GetData(); Color < (FColor*)(OutData.GetData() + OutData.Num()); ++Color)
+			{
+				*Color = BackgroundColor;
+			}
+		}
 		return;
 	}
 
@@ -121,6 +214,9 @@ void FThumbnailExporterRenderer::RenderThumbnail(FThumbnailCreationConfig& Creat
 	FThumbnailRenderTargetResource LDRThumbnail = CreateThumbnailRenderTarget(InImageWidth, InImageHeight, CreationConfig.GetAdjustedBackgroundColor());
 	FThumbnailRenderTargetResource AlphaThumbnail = CreateThumbnailRenderTarget(InImageWidth, InImageHeight, CreationConfig.GetAdjustedBackgroundColor());
 
+	const int64 RenderTargetMemory = 2 * (int64)InImageWidth * InImageHeight * sizeof(FColor);
+	INC_MEMORY_STAT_BY(STAT_ThumbnailExporter_RenderTargetMemory, RenderTargetMemory);
+
 	// Get the rendering info for this object
 	FThumbnailRenderingInfo* RenderInfo = GUnrealEd ? GUnrealEd->GetThumbnailManager()->GetRenderingInfo(UThumbnailExporterThumbnailDummy::StaticClass()->ClassDefaultObject) : nullptr;
 
@@ -128,21 +224,38 @@ void FThumbnailExporterRenderer::RenderThumbnail(FThumbnailCreationConfig& Creat
 	// @todo CB: This helps but doesn't result in 100%-streamed-in resources every time! :(
 	if (InFlushMode == ThumbnailTools::EThumbnailTextureFlushMode::AlwaysFlush)
 	{
+		PrewarmMaterialVariants(CreationConfig);
+
 		if (GShaderCompilingManager)
 		{
+			SCOPE_THUMBNAIL_EXPORT_STAGE(ShaderCompile);
 			GShaderCompilingManager->ProcessAsyncResults(false, true);
 		}
 
+		if (UMaterialInterface* Material = Cast<UMaterialInterface>(InObject))
+		{
+			FinishShaderCompilation({ Material });
+		}
+
 		if (UTexture* Texture = Cast<UTexture>(InObject))
 		{
+			SCOPE_THUMBNAIL_EXPORT_STAGE(TextureStreaming);
 			FTextureCompilingManager::Get().FinishCompilation({ Texture });
 		}
 
-		FlushAsyncLoading();
+		{
+			SCOPE_THUMBNAIL_EXPORT_STAGE(AssetLoad);
+			FlushAsyncLoading();
+		}
 
+		SCOPE_THUMBNAIL_EXPORT_STAGE(TextureStreaming);
 		IStreamingManager::Get().StreamAllResources(100.0f);
 	}
 
+	// Frames the renderer skipped because they look the same as another frame
+	TArray<FThumbnailFrameCopy> LDRFrameCopies;
+	TArray<FThumbnailFrameCopy> AlphaFrameCopies;
+
 	if (RenderInfo != NULL && RenderInfo->Renderer != NULL)
 	{
 		// Make sure we suppress any message dialogs that might result from constructing
@@ -169,6 +282,13 @@ void FThumbnailExporterRenderer::RenderThumbnail(FThumbnailCreationConfig& Creat
 			CreationParams.CreationDelegate = CreationDelegate;
 
 			OurThumbnailRenderer->DrawThumbnailWithConfig(CreationParams);
+			LDRFrameCopies = MoveTemp(CreationParams.FrameCopies);
+
+			if (OutStats)
+			{
+				OutStats->NumTriangles = CreationParams.NumTriangles;
+				OutStats->bRendered = true;
+			}
 		}
 
 		{
@@ -184,40 +304,55 @@ void FThumbnailExporterRenderer::RenderThumbnail(FThumbnailCreationConfig& Creat
 			CreationParams.CreationDelegate = CreationDelegate;
 
 			OurThumbnailRenderer->DrawThumbnailWithConfig(CreationParams);
+			AlphaFrameCopies = MoveTemp(CreationParams.FrameCopies);
 		}
 	}
 
-	// Tell the rendering thread to draw any remaining batched elements
-	LDRThumbnail.Canvas.Flush_GameThread();
-	AlphaThumbnail.Canvas.Flush_GameThread();
+	{
+		// Most of the GPU time of the two renders ends up here
+		SCOPE_THUMBNAIL_EXPORT_STAGE(FlushRendering);
+
+		// Tell the rendering thread to draw any remaining batched elements
+		LDRThumbnail.Canvas.Flush_GameThread();
+		AlphaThumbnail.Canvas.Flush_GameThread();
 
-	ENQUEUE_RENDER_COMMAND(UpdateThumbnailRTCommand)(
-		[LDRRenderTargetResource = LDRThumbnail.RenderTargetResource, AlphaRenderTargetResource = AlphaThumbnail.RenderTargetResource](FRHICommandListImmediate& RHICmdList)
-		{
-			TransitionAndCopyTexture(RHICmdList, LDRRenderTargetResource->GetRenderTargetTexture(), LDRRenderTargetResource->TextureRHI, {});
-			TransitionAndCopyTexture(RHICmdList, AlphaRenderTargetResource->GetRenderTargetTexture(), AlphaRenderTargetResource->TextureRHI, {});
-		}
-	);
+		ENQUEUE_RENDER_COMMAND(UpdateThumbnailRTCommand)(
+			[LDRRenderTargetResource = LDRThumbnail.RenderTargetResource, AlphaRenderTargetResource = AlphaThumbnail.RenderTargetResource](FRHICommandListImmediate& RHICmdList)
+			{
+				TransitionAndCopyTexture(RHICmdList, LDRRenderTargetResource->GetRenderTargetTexture(), LDRRenderTargetResource->TextureRHI, {});
+				TransitionAndCopyTexture(RHICmdList, AlphaRenderTargetResource->GetRenderTargetTexture(), AlphaRenderTargetResource->TextureRHI, {});
+			}
+		);
 
-	FlushRenderingCommands();
+		FlushRenderingCommands();
+	}
 
 	if (OutThumbnail)
 	{
 		const FIntRect InSrcRect(0, 0, OutThumbnail->GetImageWidth(), OutThumbnail->GetImageHeight());
 
 		TArray<uint8>& OutData = OutThumbnail->AccessImageData();
+		TArray<uint8> AlphaData;
+		{
+			SCOPE_THUMBNAIL_EXPORT_STAGE(Readback);
 
-		OutData.Empty();
-		OutData.AddUninitialized(OutThumbnail->GetImageWidth() * OutThumbnail->GetImageHeight() * sizeof(FColor));
+			OutData.Empty();
+			OutData.AddUninitialized(OutThumbnail->GetImageWidth() * OutThumbnail->GetImageHeight() * sizeof(FColor));
 
-		// Copy the contents of the LDR color to the thumbnail
-		// NOTE: OutData must be a preallocated buffer!
-		LDRThumbnail.RenderTargetResource->ReadPixelsPtr((FColor*)OutData.GetData(), FReadSurfaceDataFlags(), InSrcRect);
+			// Copy the contents of the LDR color to the thumbnail
+			// NOTE: OutData must be a preallocated buffer!
+			LDRThumbnail.RenderTargetResource->ReadPixelsPtr((FColor*)OutData.GetData(), FReadSurfaceDataFlags(), InSrcRect);
 
-		TArray<uint8> AlphaData;
-		AlphaData.AddUninitialized(OutThumbnail->GetImageWidth() * OutThumbnail->GetImageHeight() * sizeof(FColor));
+			AlphaData.AddUninitialized(OutThumbnail->GetImageWidth() * OutThumbnail->GetImageHeight() * sizeof(FColor));
+
+			AlphaThumbnail.RenderTargetResource->ReadPixelsPtr((FColor*)AlphaData.GetData(), FReadSurfaceDataFlags(), InSrcRect);
+		}
+
+		SCOPE_THUMBNAIL_EXPORT_STAGE(AlphaMerge);
 
-		AlphaThumbnail.RenderTargetResource->ReadPixelsPtr((FColor*)AlphaData.GetData(), FReadSurfaceDataFlags(), InSrcRect);
+		// Fill in the frames the renderer skipped before the alpha is merged in
+		CopyFrames(OutData, OutThumbnail->GetImageWidth(), LDRFrameCopies);
+		CopyFrames(AlphaData, OutThumbnail->GetImageWidth(), AlphaFrameCopies);
 
 		FColor* Color = (FColor*)OutData.GetData();
 		FColor* Alpha = (FColor*)AlphaData.GetData();
@@ -236,4 +371,5 @@ void FThumbnailExporterRenderer::RenderThumbnail(FThumbnailCreationConfig& Creat
 			}
 		}
 	}
+	DEC_MEMORY_STAT_BY(STAT_ThumbnailExporter_RenderTargetMemory, RenderTargetMemory);
 }
\ No newline at end of file
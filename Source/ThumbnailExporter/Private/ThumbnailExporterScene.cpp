@@ -3,11 +3,28 @@
 
 #include "ThumbnailExporterScene.h"
 
+#include "ThumbnailExporterSettings.h"
+#include "ThumbnailExporterStats.h"
 #include "ContentStreaming.h"
 #include "EngineUtils.h"
+#include "Engine/Engine.h"
 #include "ThumbnailRendering/SceneThumbnailInfo.h"
 #include "Engine/StaticMeshActor.h"
-#include "Components/SkyLightComponent.h"
+#include "Animation/AnimSequence.h"
+#include "Animation/AnimSingleNodeInstance.h"
+#include "Engine/SkeletalMesh.h"
+#include "Rendering/SkeletalMeshRenderData.h"
+#include "StaticMeshResources.h"
+#include "SceneManagement.h"
+#if ENGINE_MINOR_VERSION > 0
+#include "Engine/SkinnedAssetCommon.h"
+#endif
+#include "ThumbnailExporterSkyLightComponent.h"
+#include "Components/DirectionalLightComponent.h"
+#include "Engine/BlueprintGeneratedClass.h"
+#include "Engine/SimpleConstructionScript.h"
+#include "Engine/SCS_Node.h"
+#include "Engine/StaticMeshSocket.h"
 
 static USkeletalMesh* GetSkeletalMesh(USkeletalMeshComponent* SkelMeshComp)
 {
@@ -18,21 +35,232 @@ static USkeletalMesh* GetSkeletalMesh(USkeletalMeshComponent* SkelMeshComp)
 #endif
 }
 
-FThumbnailExporterScene::FThumbnailExporterScene(bool bInHideBackgroundMeshes)
+static bool IsCompatibleSkeleton(const USkeleton* Skeleton, const USkeleton* OtherSkeleton)
+{
+#if ENGINE_MINOR_VERSION < 3
+	return Skeleton->IsCompatible(OtherSkeleton);
+#else
+	return Skeleton->IsCompatibleForEditor(OtherSkeleton);
+#endif
+}
+
+// A visual component template of an actor class, and where it sits relative to the actor
+struct FVisualComponentTemplate
+{
+	UPrimitiveComponent* Template;
+	FTransform ComponentToActor;
+};
+
+// Returns the transform of the socket relative to the template, or nothing if it can't be known without spawning the actor.
+// Static mesh sockets are part of the mesh asset, anything else (e.g. skeletal mesh bones) needs a posed, registered component
+static TOptional<FTransform> GetTemplateSocketTransform(USceneComponent* ParentTemplate, FName SocketName)
+{
+	if (SocketName == NAME_None)
+	{
+		return FTransform::Identity;
+	}
+
+	const UStaticMeshComponent* StaticMeshTemplate = Cast<UStaticMeshComponent>(ParentTemplate);
+	const UStaticMeshSocket* Socket = StaticMeshTemplate ? StaticMeshTemplate->GetSocketByName(SocketName) : nullptr;
+	if (Socket == nullptr)
+	{
+		return {};
+	}
+
+	return FTransform(Socket->RelativeRotation, Socket->RelativeLocation, Socket->RelativeScale);
+}
+
+// Gathers the native component templates of the class's default object and the construction script templates of its blueprints,
+// and keeps the ones that pass IsValidComponentForVisualization.
+// Returns false if a visual template is attached to a socket whose transform can't be resolved from the templates alone,
+// in which case the class has to be fully spawned to place it correctly
+static bool GetVisualComponentTemplates(UClass* InClass, TArray<FVisualComponentTemplate>& OutVisualTemplates)
+{
+	AActor* CDO = InClass->GetDefaultObject<AActor>();
+
+	TArray<USceneComponent*> Templates;
+	// The template each scene component template is attached to
+	TMap<USceneComponent*, USceneComponent*> AttachParents;
+	// The parent socket each scene component template is attached to, if any
+	TMap<USceneComponent*, FName> AttachSocketNames;
+
+	TArray<UObject*> DefaultSubobjects;
+	CDO->GetDefaultSubobjects(DefaultSubobjects);
+	for (UObject* DefaultSubobject : DefaultSubobjects)
+	{
+		if (USceneComponent* NativeTemplate = Cast<USceneComponent>(DefaultSubobject))
+		{
+			Templates.Add(NativeTemplate);
+			AttachParents.Add(NativeTemplate, NativeTemplate->GetAttachParent());
+			AttachSocketNames.Add(NativeTemplate, NativeTemplate->GetAttachSocketName());
+		}
+	}
+
+	USceneComponent* RootTemplate = CDO->GetRootComponent();
+
+	UBlueprintGeneratedClass* ActualClass = Cast<UBlueprintGeneratedClass>(InClass);
+	TArray<const UBlueprintGeneratedClass*> BlueprintClasses;
+	UBlueprintGeneratedClass::GetGeneratedClassesHierarchy(InClass, BlueprintClasses);
+
+	// Templates of every construction script node, with overrides from child blueprints applied
+	TMap<FName, USceneComponent*> NodeTemplatesByVariableName;
+	for (const UBlueprintGeneratedClass* BlueprintClass : BlueprintClasses)
+	{
+		if (const USimpleConstructionScript* SCS = BlueprintClass->SimpleConstructionScript)
+		{
+			for (USCS_Node* Node : SCS->GetAllNodes())
+			{
+				if (USceneComponent* NodeTemplate = Cast<USceneComponent>(Node->GetActualComponentTemplate(ActualClass)))
+				{
+					Templates.Add(NodeTemplate);
+					NodeTemplatesByVariableName.Add(Node->GetVariableName(), NodeTemplate);
+				}
+			}
+		}
+	}
+
+	// Parent classes first, so a construction script without a native root gets its scene root from the oldest blueprint
+	for (int32 ClassIndex = BlueprintClasses.Num() - 1; ClassIndex >= 0; --ClassIndex)
+	{
+		const USimpleConstructionScript* SCS = BlueprintClasses[ClassIndex]->SimpleConstructionScript;
+		if (SCS == nullptr)
+		{
+			continue;
+		}
+
+		for (USCS_Node* Node : SCS->GetAllNodes())
+		{
+			USceneComponent* NodeTemplate = NodeTemplatesByVariableName.FindRef(Node->GetVariableName());
+			for (USCS_Node* ChildNode : Node->GetChildNodes())
+			{
+				if (USceneComponent* ChildTemplate = NodeTemplatesByVariableName.FindRef(ChildNode->GetVariableName()))
+				{
+					AttachParents.Add(ChildTemplate, NodeTemplate);
+					AttachSocketNames.Add(ChildTemplate, ChildNode->AttachToName);
+				}
+			}
+		}
+
+		for (USCS_Node* RootNode : SCS->GetRootNodes())
+		{
+			USceneComponent* NodeTemplate = NodeTemplatesByVariableName.FindRef(RootNode->GetVariableName());
+			if (NodeTemplate == nullptr)
+			{
+				continue;
+			}
+
+			USceneComponent* ParentTemplate = nullptr;
+			if (RootNode->ParentComponentOrVariableName != NAME_None)
+			{
+				if (RootNode->bIsParentComponentNative)
+				{
+					USceneComponent* const* NativeParent = Templates.FindByPredicate([RootNode](const USceneComponent* Template) { return Template->GetFName() == RootNode->ParentComponentOrVariableName; });
+					ParentTemplate = NativeParent ? *NativeParent : nullptr;
+				}
+				else
+				{
+					ParentTemplate = NodeTemplatesByVariableName.FindRef(RootNode->ParentComponentOrVariableName);
+				}
+			}
+			else if (RootTemplate == nullptr)
+			{
+				RootTemplate = NodeTemplate;
+			}
+			else
+			{
+				ParentTemplate = RootTemplate;
+			}
+
+			AttachParents.Add(NodeTemplate, ParentTemplate);
+			AttachSocketNames.Add(NodeTemplate, ParentTemplate ? RootNode->AttachToName : NAME_None);
+		}
+	}
+
+	bool bResolvedAllTransforms = true;
+	for (USceneComponent* Template : Templates)
+	{
+		if (!FThumbnailExporterScene::IsValidComponentForVisualization(Template))
+		{
+			continue;
+		}
+
+		// A spawned actor places its root at RootTransform * SpawnTransform, so the root's relative transform counts as well
+		FTransform ComponentToActor = FTransform::Identity;
+		for (USceneComponent* Component = Template; Component; Component = AttachParents.FindRef(Component))
+		{
+			ComponentToActor = ComponentToActor * Component->GetRelativeTransform();
+
+			USceneComponent* ParentTemplate = AttachParents.FindRef(Component);
+			if (ParentTemplate == nullptr)
+			{
+				break;
+			}
+
+			const TOptional<FTransform> SocketTransform = GetTemplateSocketTransform(ParentTemplate, AttachSocketNames.FindRef(Component));
+			if (!SocketTransform.IsSet())
+			{
+				bResolvedAllTransforms = false;
+				break;
+			}
+
+			ComponentToActor = ComponentToActor * SocketTransform.GetValue();
+		}
+
+		OutVisualTemplates.Add({ CastChecked<UPrimitiveComponent>(Template), ComponentToActor });
+	}
+
+	return bResolvedAllTransforms;
+}
+
+FThumbnailExporterSceneKey::FThumbnailExporterSceneKey(const FThumbnailCreationConfig& CreationConfig)
+	: bHideBackgroundMeshes(CreationConfig.bHideThumbnailBackgroundMeshes || CreationConfig.bUseMinimalScene)
+	, bMinimalScene(CreationConfig.bUseMinimalScene)
+{
+
+}
+
+FThumbnailExporterScene::FThumbnailExporterScene(const FThumbnailExporterSceneKey& InSceneKey)
 	: FThumbnailPreviewScene()
-	, bHideBackgroundMeshes(bInHideBackgroundMeshes)
+	, SceneKey(InSceneKey)
 	, NumStartingActors(0)
 	, PreviewActor(nullptr)
 	, CurrentBlueprint(nullptr)
+	, FramingMode(EThumbnailFramingMode::BoundingSphere)
+	, FramingMargin(0.f)
+	, NumTurntableAngles(1)
+	, TurntableAngle(0)
+	, TurntableStartYaw(0.f)
+	, bFacePreviewMesh(false)
 {
 	NumStartingActors = GetWorld()->GetCurrentLevel()->Actors.Num();
 
+	// Swap the preview scene's sky light for one that is captured now, instead of whenever the engine gets around to it.
+	// Pooled scenes share the capture, so only the first scene pays for it
 	if (SkyLight)
 	{
-		//SkyLight->Set
-		//UE_LOG(LogTemp, Warning, TEXT("asdf"));
-		//SkyLight->RecaptureSky();
-		//USkyLightComponent::UpdateSkyCaptureContents(SkyLight->GetWorld());
+		UThumbnailExporterSkyLightComponent* ExporterSkyLight = NewObject<UThumbnailExporterSkyLightComponent>(GetTransientPackage());
+		UEngine::CopyPropertiesForUnrelatedObjects(SkyLight, ExporterSkyLight);
+		RemoveComponent(SkyLight);
+		SkyLight = ExporterSkyLight;
+		AddComponent(ExporterSkyLight, FTransform::Identity);
+		ExporterSkyLight->CaptureOnce();
+	}
+
+	if (SceneKey.bMinimalScene)
+	{
+		// Take the background meshes and the extra lights the thumbnail preview scene added out of the scene entirely.
+		// The scene's own directional light stays as the first of the minimal scene lights
+		const auto SceneComponents = Components;
+		for (UActorComponent* Component : SceneComponents)
+		{
+			if (Component->IsA<UStaticMeshComponent>() || (Component->IsA<UDirectionalLightComponent>() && Component != DirectionalLight))
+			{
+				RemoveComponent(Component);
+			}
+		}
+
+		MinimalSceneLights.Add(DirectionalLight);
+		return;
 	}
 
 	// Iterate over all of the objects inside the scene and hide them
@@ -48,7 +276,7 @@ FThumbnailExporterScene::FThumbnailExporterScene(bool bInHideBackgroundMeshes)
 		UActorComponent* Component = *ObjectItr;
 		if (UStaticMeshComponent* MeshComponent = Cast<UStaticMeshComponent>(Component))
 		{
-			if (bHideBackgroundMeshes)
+			if (SceneKey.bHideBackgroundMeshes)
 			{
 				MeshComponent->SetRenderInMainPass(false);
 			}
@@ -60,21 +288,75 @@ FThumbnailExporterScene::FThumbnailExporterScene(bool bInHideBackgroundMeshes)
 	}
 }
 
+void FThumbnailExporterScene::SetMinimalSceneLights(const TArray<FThumbnailSceneLight>& Lights, float SkyBrightness)
+{
+	if (!SceneKey.bMinimalScene)
+	{
+		return;
+	}
+
+	if (SkyBrightness != AppliedMinimalSceneSkyBrightness)
+	{
+		SetSkyBrightness(SkyBrightness);
+		AppliedMinimalSceneSkyBrightness = SkyBrightness;
+	}
+
+	if (Lights == AppliedMinimalSceneLights)
+	{
+		return;
+	}
+
+	// Keep the first light even with no lights configured, the preview scene expects its directional light to be there
+	while (MinimalSceneLights.Num() < Lights.Num())
+	{
+		UDirectionalLightComponent* Light = NewObject<UDirectionalLightComponent>(GetTransientPackage());
+		AddComponent(Light, FTransform::Identity);
+		MinimalSceneLights.Add(Light);
+	}
+	while (MinimalSceneLights.Num() > FMath::Max(Lights.Num(), 1))
+	{
+		RemoveComponent(MinimalSceneLights.Pop());
+	}
+
+	for (int32 LightIndex = 0; LightIndex < MinimalSceneLights.Num(); ++LightIndex)
+	{
+		UDirectionalLightComponent* Light = MinimalSceneLights[LightIndex];
+		if (Lights.IsValidIndex(LightIndex))
+		{
+			Light->SetWorldRotation(Lights[LightIndex].Rotation);
+			Light->SetIntensity(Lights[LightIndex].Intensity);
+			Light->SetLightColor(Lights[LightIndex].Color);
+		}
+		else
+		{
+			Light->SetIntensity(0.f);
+		}
+		Light->DoDeferredRenderUpdates_Concurrent();
+	}
+
+	AppliedMinimalSceneLights = Lights;
+}
+
 FSceneView* FThumbnailExporterScene::CreateView(FSceneViewFamily* ViewFamily, int32 X, int32 Y, uint32 SizeX, uint32 SizeY) const
 {
 	FSceneView* View = FThumbnailPreviewScene::CreateView(ViewFamily, X, Y, SizeX, SizeY);
 
 	View->bIsSceneCapture = true;
 
+	return View;
+}
+
+void FThumbnailExporterScene::StreamTextures(const FSceneView& View) const
+{
 	const float FOVDegrees = 30.f;
+	const int32 SizeX = View.UnscaledViewRect.Width();
 
+	SCOPE_THUMBNAIL_EXPORT_STAGE(TextureStreaming);
 	for (TActorIterator<AActor> It(GetWorld()); It; ++It)
 	{
-		IStreamingManager::Get().AddViewInformation(View->ViewMatrices.GetViewOrigin(), SizeX, SizeX / FMath::Tan(FOVDegrees), 10.f, false, 5.f, *It);
+		IStreamingManager::Get().AddViewInformation(View.ViewMatrices.GetViewOrigin(), SizeX, SizeX / FMath::Tan(FOVDegrees), 10.f, false, 5.f, *It);
 	}
 	IStreamingManager::Get().StreamAllResources();
-
-	return View;
 }
 
 bool FThumbnailExporterScene::IsValidComponentForVisualization(UActorComponent* Component)
@@ -98,11 +380,24 @@ bool FThumbnailExporterScene::IsValidComponentForVisualization(UActorComponent*
 	return false;
 }
 
-void FThumbnailExporterScene::SetBlueprint(UBlueprint* Blueprint)
+bool FThumbnailExporterScene::HasVisualComponentTemplates(UClass* InClass)
+{
+	if (InClass == nullptr || !InClass->IsChildOf<AActor>())
+	{
+		return false;
+	}
+
+	TArray<FVisualComponentTemplate> VisualTemplates;
+	GetVisualComponentTemplates(InClass, VisualTemplates);
+	return VisualTemplates.Num() > 0;
+}
+
+void FThumbnailExporterScene::SetBlueprint(UBlueprint* Blueprint, EThumbnailBlueprintSpawnMode SpawnMode)
 {
 	CurrentBlueprint = Blueprint;
+	BlueprintSpawnMode = SpawnMode;
 	UClass* BPClass = (Blueprint ? Blueprint->GeneratedClass : nullptr);
-	SpawnPreviewActor(BPClass);
+	SpawnPreviewActor(BPClass, BlueprintSpawnMode == EThumbnailBlueprintSpawnMode::VisualComponentsOnly);
 }
 
 void FThumbnailExporterScene::BlueprintChanged(UBlueprint* Blueprint)
@@ -110,7 +405,7 @@ void FThumbnailExporterScene::BlueprintChanged(UBlueprint* Blueprint)
 	if (CurrentBlueprint == Blueprint)
 	{
 		UClass* BPClass = (Blueprint ? Blueprint->GeneratedClass : nullptr);
-		SpawnPreviewActor(BPClass);
+		SpawnPreviewActor(BPClass, BlueprintSpawnMode == EThumbnailBlueprintSpawnMode::VisualComponentsOnly);
 	}
 }
 
@@ -120,6 +415,7 @@ void FThumbnailExporterScene::SetStaticMesh(UStaticMesh* StaticMesh)
 
 	if (AStaticMeshActor* StaticMeshPreview = Cast<AStaticMeshActor>(PreviewActor))
 	{
+		StaticMeshPreview->GetStaticMeshComponent()->OverrideMaterials.Empty();
 		StaticMeshPreview->GetStaticMeshComponent()->SetStaticMesh(StaticMesh);
 
 		if (StaticMesh)
@@ -172,96 +468,341 @@ void FThumbnailExporterScene::SetSkeletalMesh(USkeletalMesh* InSkeletalMesh)
 	}
 }
 
-void FThumbnailExporterScene::SetOverrideMaterials(const TArray<class UMaterialInterface*>& OverrideMaterials)
+bool FThumbnailExporterScene::SetSkeletalMeshAnimation(UAnimSequence* Animation)
 {
-	if (AStaticMeshActor* StaticMeshPreview = Cast<AStaticMeshActor>(PreviewActor))
+	ASkeletalMeshActor* SkeletalMeshPreview = Cast<ASkeletalMeshActor>(PreviewActor);
+	if (SkeletalMeshPreview == nullptr)
+	{
+		return Animation == nullptr;
+	}
+
+	USkeletalMeshComponent* SkeletalMeshComponent = SkeletalMeshPreview->GetSkeletalMeshComponent();
+	USkeletalMesh* SkeletalMesh = GetSkeletalMesh(SkeletalMeshComponent);
+	const bool bCanPlayAnimation = Animation && SkeletalMesh && SkeletalMesh->GetSkeleton() && IsCompatibleSkeleton(SkeletalMesh->GetSkeleton(), Animation->GetSkeleton());
+
+	if (bCanPlayAnimation)
 	{
-		StaticMeshPreview->GetStaticMeshComponent()->OverrideMaterials = OverrideMaterials;
-		StaticMeshPreview->GetStaticMeshComponent()->MarkRenderStateDirty();
+		// Keep the bounds of the reference pose, so the framing (and the camera) doesn't move from pose to pose
+		SkeletalMeshComponent->bComponentUseFixedSkelBounds = true;
+		SkeletalMeshComponent->SetAnimationMode(EAnimationMode::AnimationSingleNode);
+		SkeletalMeshComponent->SetAnimation(Animation);
+		SetSkeletalMeshAnimationTime(0.f);
 	}
+	else if (SkeletalMeshComponent->GetAnimationMode() == EAnimationMode::AnimationSingleNode)
+	{
+		// The preview actor is reused between thumbnails, so undo the last animation
+		SkeletalMeshComponent->bComponentUseFixedSkelBounds = false;
+		SkeletalMeshComponent->SetAnimationMode(EAnimationMode::AnimationBlueprint);
+		SkeletalMeshComponent->ClearAnimScriptInstance();
+		SkeletalMeshComponent->RefreshBoneTransforms();
+		SkeletalMeshComponent->UpdateBounds();
+		SkeletalMeshComponent->DoDeferredRenderUpdates_Concurrent();
+	}
+
+	return bCanPlayAnimation || Animation == nullptr;
 }
 
-void FThumbnailExporterScene::GetViewMatrixParameters(const float InFOVDegrees, FVector& OutOrigin, float& OutOrbitPitch, float& OutOrbitYaw, float& OutOrbitZoom) const
+void FThumbnailExporterScene::SetSkeletalMeshAnimationTime(float Time)
 {
-	if (AStaticMeshActor* StaticMeshPreview = Cast<AStaticMeshActor>(PreviewActor))
+	ASkeletalMeshActor* SkeletalMeshPreview = Cast<ASkeletalMeshActor>(PreviewActor);
+	if (SkeletalMeshPreview == nullptr)
 	{
-		const float HalfFOVRadians = FMath::DegreesToRadians<float>(InFOVDegrees) * 0.5f;
-		// Add extra size to view slightly outside of the sphere to compensate for perspective
-		const float HalfMeshSize = StaticMeshPreview->GetStaticMeshComponent()->Bounds.SphereRadius * 1.15;
-		const float BoundsZOffset = GetBoundsZOffset(StaticMeshPreview->GetStaticMeshComponent()->Bounds);
-		const float TargetDistance = HalfMeshSize / FMath::Tan(HalfFOVRadians);
+		return;
+	}
+
+	USkeletalMeshComponent* SkeletalMeshComponent = SkeletalMeshPreview->GetSkeletalMeshComponent();
+	UAnimSingleNodeInstance* SingleNodeInstance = SkeletalMeshComponent->GetSingleNodeInstance();
+	if (SingleNodeInstance == nullptr)
+	{
+		return;
+	}
 
-		USceneThumbnailInfo* ThumbnailInfo = Cast<USceneThumbnailInfo>(StaticMeshPreview->GetStaticMeshComponent()->GetStaticMesh()->ThumbnailInfo);
-		if (ThumbnailInfo)
+	// Evaluate the pose right away instead of waiting for the world to tick, then push it to the render thread.
+	// Render commands run in order, so the pose is in place for the view family rendered next, and the one after that can be posed while it renders
+	SingleNodeInstance->SetPosition(Time, false);
+	SkeletalMeshComponent->TickAnimation(0.f, false);
+	SkeletalMeshComponent->RefreshBoneTransforms();
+	SkeletalMeshComponent->DoDeferredRenderUpdates_Concurrent();
+}
+
+void FThumbnailExporterScene::SetMaterial(UMaterialInterface* Material, UStaticMesh* PreviewMesh, bool bInFacePreviewMesh)
+{
+	// When the preview mesh is already in the scene only the material is swapped, so the mesh's render state, bounds and framing are reused
+	AStaticMeshActor* StaticMeshPreview = Cast<AStaticMeshActor>(PreviewActor);
+	if (StaticMeshPreview == nullptr || StaticMeshPreview->GetStaticMeshComponent()->GetStaticMesh() != PreviewMesh)
+	{
+		SetStaticMesh(PreviewMesh);
+	}
+
+	bFacePreviewMesh = bInFacePreviewMesh;
+	SetOverrideMaterials({ Material });
+}
+
+// Returns the LOD to render a mesh with NumLODs LODs at, according to the config's LOD policy
+static int32 SelectLOD(const FThumbnailCreationConfig& CreationConfig, const FSceneView& View, float FrameHeight, const FBoxSphereBounds& Bounds, int32 NumLODs, TFunctionRef<float(int32)> GetLODScreenSize)
+{
+	switch (CreationConfig.LODPolicy)
+	{
+	case EThumbnailLODPolicy::Automatic:
+	{
+		// LOD screen sizes are a fraction of the screen, and the asset fills most of the thumbnail. Scaling by how small the thumbnail
+		// is compared to the reference screen gives the LOD the mesh would get if it covered the same number of pixels on that screen
+		const float ScreenSize = ComputeBoundsScreenSize(Bounds.Origin, Bounds.SphereRadius, View) * FrameHeight / FMath::Max(CreationConfig.LODReferenceScreenHeight, 1.f);
+
+		// Same rule as the engine: the coarsest LOD that would still be used at this screen size
+		for (int32 LODIndex = NumLODs - 1; LODIndex > 0; --LODIndex)
 		{
-			if (TargetDistance + ThumbnailInfo->OrbitZoom < 0)
+			if (GetLODScreenSize(LODIndex) > ScreenSize)
 			{
-				ThumbnailInfo->OrbitZoom = -TargetDistance;
+				return LODIndex;
 			}
 		}
-		else
+		return 0;
+	}
+
+	case EThumbnailLODPolicy::Fixed:
+		return FMath::Clamp(CreationConfig.FixedLOD, 0, NumLODs - 1);
+
+	default:
+		return 0;
+	}
+}
+
+int64 FThumbnailExporterScene::ApplyLODPolicy(const FThumbnailCreationConfig& CreationConfig, const FSceneView& View, float FrameHeight)
+{
+	if (!PreviewActor.IsValid())
+	{
+		return 0;
+	}
+
+	int64 NumTriangles = 0;
+
+	TInlineComponentArray<UStaticMeshComponent*> StaticMeshComponents(PreviewActor.Get());
+	for (UStaticMeshComponent* StaticMeshComponent : StaticMeshComponents)
+	{
+		const UStaticMesh* StaticMesh = StaticMeshComponent->GetStaticMesh();
+		const FStaticMeshRenderData* RenderData = StaticMesh ? StaticMesh->GetRenderData() : nullptr;
+		if (RenderData == nullptr || RenderData->LODResources.Num() == 0)
 		{
-			ThumbnailInfo = USceneThumbnailInfo::StaticClass()->GetDefaultObject<USceneThumbnailInfo>();
+			continue;
 		}
 
-		OutOrigin = FVector(0, 0, -BoundsZOffset);
-		OutOrbitPitch = ThumbnailInfo->OrbitPitch;
-		OutOrbitYaw = ThumbnailInfo->OrbitYaw;
-		OutOrbitZoom = TargetDistance + ThumbnailInfo->OrbitZoom;
+		const int32 LODIndex = SelectLOD(CreationConfig, View, FrameHeight, StaticMeshComponent->Bounds, RenderData->LODResources.Num(),
+			[RenderData](int32 Index) { return RenderData->ScreenSize[Index].GetValue(); });
+
+		// Forced LODs are 1 based, 0 lets the engine pick
+		if (StaticMeshComponent->ForcedLodModel != LODIndex + 1)
+		{
+			StaticMeshComponent->SetForcedLodModel(LODIndex + 1);
+			StaticMeshComponent->DoDeferredRenderUpdates_Concurrent();
+		}
+
+		NumTriangles += RenderData->LODResources[LODIndex].GetNumTriangles();
 	}
-	else if (ASkeletalMeshActor* SkeletalMeshPreview = Cast<ASkeletalMeshActor>(PreviewActor))
-	{
-		const float HalfFOVRadians = FMath::DegreesToRadians<float>(InFOVDegrees) * 0.5f;
-		// No need to add extra size to view slightly outside of the sphere to compensate for perspective since skeletal meshes already buffer bounds.
-		const float HalfMeshSize = static_cast<float>(SkeletalMeshPreview->GetSkeletalMeshComponent()->Bounds.SphereRadius);
-		const float BoundsZOffset = GetBoundsZOffset(SkeletalMeshPreview->GetSkeletalMeshComponent()->Bounds);
-		const float TargetDistance = HalfMeshSize / FMath::Tan(HalfFOVRadians);
 
-		USceneThumbnailInfo* ThumbnailInfo = nullptr;
-		if (SkeletalMeshPreview->GetSkeletalMeshComponent()->GetSkeletalMeshAsset())
+	TInlineComponentArray<USkeletalMeshComponent*> SkeletalMeshComponents(PreviewActor.Get());
+	for (USkeletalMeshComponent* SkeletalMeshComponent : SkeletalMeshComponents)
+	{
+		USkeletalMesh* SkeletalMesh = GetSkeletalMesh(SkeletalMeshComponent);
+		const FSkeletalMeshRenderData* RenderData = SkeletalMesh ? SkeletalMesh->GetResourceForRendering() : nullptr;
+		if (RenderData == nullptr || RenderData->LODRenderData.Num() == 0)
 		{
-			ThumbnailInfo = Cast<USceneThumbnailInfo>(SkeletalMeshPreview->GetSkeletalMeshComponent()->GetSkeletalMeshAsset()->GetThumbnailInfo());
+			continue;
 		}
 
-		if (ThumbnailInfo)
+		const int32 LODIndex = SelectLOD(CreationConfig, View, FrameHeight, SkeletalMeshComponent->Bounds, RenderData->LODRenderData.Num(),
+			[SkeletalMesh](int32 Index) { const FSkeletalMeshLODInfo* LODInfo = SkeletalMesh->GetLODInfo(Index); return LODInfo ? LODInfo->ScreenSize.GetValue() : 0.f; });
+
+		if (SkeletalMeshComponent->GetForcedLOD() != LODIndex + 1)
 		{
-			if (TargetDistance + ThumbnailInfo->OrbitZoom < 0)
-			{
-				ThumbnailInfo->OrbitZoom = -TargetDistance;
-			}
+			SkeletalMeshComponent->SetForcedLOD(LODIndex + 1);
+			SkeletalMeshComponent->DoDeferredRenderUpdates_Concurrent();
 		}
-		else
+
+		NumTriangles += RenderData->LODRenderData[LODIndex].GetTotalFaces();
+	}
+
+	return NumTriangles;
+}
+
+void FThumbnailExporterScene::SetFraming(EThumbnailFramingMode InFramingMode, float InFramingMargin)
+{
+	FramingMode = InFramingMode;
+	FramingMargin = InFramingMargin;
+}
+
+void FThumbnailExporterScene::SetTurntable(int32 InNumTurntableAngles, float InTurntableStartYaw, TOptional<float> InTurntablePitch)
+{
+	NumTurntableAngles = FMath::Max(InNumTurntableAngles, 1);
+	TurntableStartYaw = InTurntableStartYaw;
+	TurntablePitch = InTurntablePitch;
+	TurntableAngle = 0;
+}
+
+void FThumbnailExporterScene::SetTurntableAngle(int32 InTurntableAngle)
+{
+	TurntableAngle = InTurntableAngle;
+}
+
+float FThumbnailExporterScene::GetTurntableYawOffset(int32 InTurntableAngle) const
+{
+	if (NumTurntableAngles <= 1)
+	{
+		return 0.f;
+	}
+
+	return TurntableStartYaw + 360.f * InTurntableAngle / NumTurntableAngles;
+}
+
+void FThumbnailExporterScene::SetOverrideMaterials(const TArray<class UMaterialInterface*>& OverrideMaterials)
+{
+	UMeshComponent* MeshComponent = nullptr;
+	if (AStaticMeshActor* StaticMeshPreview = Cast<AStaticMeshActor>(PreviewActor))
+	{
+		MeshComponent = StaticMeshPreview->GetStaticMeshComponent();
+	}
+	else if (ASkeletalMeshActor* SkeletalMeshPreview = Cast<ASkeletalMeshActor>(PreviewActor))
+	{
+		MeshComponent = SkeletalMeshPreview->GetSkeletalMeshComponent();
+	}
+
+	if (MeshComponent)
+	{
+		// Only the render state is recreated, the mesh stays streamed in and the bounds (and so the framing) don't change.
+		// Send it to the render thread right away so the next rendered view family already uses the new materials
+		MeshComponent->OverrideMaterials = OverrideMaterials;
+		MeshComponent->MarkRenderStateDirty();
+		MeshComponent->DoDeferredRenderUpdates_Concurrent();
+	}
+}
+
+void FThumbnailExporterScene::GetViewMatrixParameters(const float InFOVDegrees, FVector& OutOrigin, float& OutOrbitPitch, float& OutOrbitYaw, float& OutOrbitZoom) const
+{
+	const float HalfFOVRadians = FMath::DegreesToRadians<float>(InFOVDegrees) * 0.5f;
+
+	FBoxSphereBounds Bounds(ForceInitToZero);
+	// Add extra size to view slightly outside of the sphere to compensate for perspective
+	float SphereRadiusScale = 1.15f;
+	USceneThumbnailInfo* ThumbnailInfo = nullptr;
+	const UObject* FramedAsset = nullptr;
+
+	if (AStaticMeshActor* StaticMeshPreview = Cast<AStaticMeshActor>(PreviewActor))
+	{
+		Bounds = StaticMeshPreview->GetStaticMeshComponent()->Bounds;
+		FramedAsset = StaticMeshPreview->GetStaticMeshComponent()->GetStaticMesh();
+		ThumbnailInfo = Cast<USceneThumbnailInfo>(StaticMeshPreview->GetStaticMeshComponent()->GetStaticMesh()->ThumbnailInfo);
+	}
+	else if (ASkeletalMeshActor* SkeletalMeshPreview = Cast<ASkeletalMeshActor>(PreviewActor))
+	{
+		Bounds = SkeletalMeshPreview->GetSkeletalMeshComponent()->Bounds;
+		// No need to add extra size to view slightly outside of the sphere to compensate for perspective since skeletal meshes already buffer bounds.
+		SphereRadiusScale = 1.f;
+		FramedAsset = GetSkeletalMesh(SkeletalMeshPreview->GetSkeletalMeshComponent());
+		if (FramedAsset)
 		{
-			ThumbnailInfo = USceneThumbnailInfo::StaticClass()->GetDefaultObject<USceneThumbnailInfo>();
+			ThumbnailInfo = Cast<USceneThumbnailInfo>(GetSkeletalMesh(SkeletalMeshPreview->GetSkeletalMeshComponent())->GetThumbnailInfo());
 		}
+	}
+	else
+	{
+		Bounds = GetPreviewActorBounds();
+		FramedAsset = CurrentBlueprint.Get();
+		ThumbnailInfo = GetSceneThumbnailInfo();
+	}
 
-		OutOrigin = FVector(0, 0, -BoundsZOffset);
-		OutOrbitPitch = ThumbnailInfo->OrbitPitch;
-		OutOrbitYaw = ThumbnailInfo->OrbitYaw;
-		OutOrbitZoom = TargetDistance + ThumbnailInfo->OrbitZoom;
+	if (ThumbnailInfo == nullptr)
+	{
+		ThumbnailInfo = USceneThumbnailInfo::StaticClass()->GetDefaultObject<USceneThumbnailInfo>();
+	}
+
+	const float BoundsZOffset = GetBoundsZOffset(Bounds);
+	const float BaseOrbitYaw = bFacePreviewMesh ? 0.f : ThumbnailInfo->OrbitYaw;
+	OutOrigin = FVector(0, 0, -BoundsZOffset);
+	OutOrbitPitch = bFacePreviewMesh ? 0.f : TurntablePitch.Get(ThumbnailInfo->OrbitPitch);
+	OutOrbitYaw = BaseOrbitYaw + GetTurntableYawOffset(TurntableAngle);
+
+	float TargetDistance = 0.f;
+	if (FramingMode == EThumbnailFramingMode::BoundingBox)
+	{
+		// Turntable frames all use the zoom of the widest angle, so the asset stays the same size from frame to frame
+		for (int32 Angle = 0; Angle < NumTurntableAngles; ++Angle)
+		{
+			const float AngleOrbitYaw = BaseOrbitYaw + GetTurntableYawOffset(Angle);
+			TargetDistance = FMath::Max(TargetDistance, GetBoundingBoxOrbitZoom(FramedAsset, Bounds, OutOrigin, HalfFOVRadians, OutOrbitPitch, AngleOrbitYaw));
+		}
 	}
 	else
 	{
-		const float HalfFOVRadians = FMath::DegreesToRadians<float>(InFOVDegrees) * 0.5f;
-		// Add extra size to view slightly outside of the sphere to compensate for perspective
-		const FBoxSphereBounds Bounds = GetPreviewActorBounds();
+		const float HalfMeshSize = Bounds.SphereRadius * SphereRadiusScale;
+		TargetDistance = HalfMeshSize / FMath::Tan(HalfFOVRadians);
+	}
+
+	if (TargetDistance + ThumbnailInfo->OrbitZoom < 0 && !ThumbnailInfo->HasAnyFlags(RF_ClassDefaultObject))
+	{
+		ThumbnailInfo->OrbitZoom = -TargetDistance;
+	}
+
+	OutOrbitZoom = TargetDistance + ThumbnailInfo->OrbitZoom;
+}
+
+float FThumbnailExporterScene::GetBoundingBoxOrbitZoom(const UObject* FramedAsset, const FBoxSphereBounds& Bounds, const FVector& Origin, float HalfFOVRadians, float OrbitPitch, float OrbitYaw) const
+{
+	const FObjectKey FramedAssetKey(FramedAsset);
+	if (FramedAssetKey != FramingCacheAsset)
+	{
+		FramingCache.Reset();
+		FramingCacheAsset = FramedAssetKey;
+	}
 
-		const float HalfMeshSize = Bounds.SphereRadius * 1.15;
-		const float BoundsZOffset = GetBoundsZOffset(Bounds);
-		const float TargetDistance = HalfMeshSize / FMath::Tan(HalfFOVRadians);
+	if (const FFramingCacheEntry* CachedFraming = FramingCache.Find(OrbitYaw))
+	{
+		if (CachedFraming->Bounds.Origin == Bounds.Origin && CachedFraming->Bounds.BoxExtent == Bounds.BoxExtent
+			&& CachedFraming->HalfFOVRadians == HalfFOVRadians && CachedFraming->OrbitPitch == OrbitPitch && CachedFraming->OrbitYaw == OrbitYaw
+			&& CachedFraming->FramingMargin == FramingMargin)
+		{
+			return CachedFraming->OrbitZoom;
+		}
+	}
 
-		USceneThumbnailInfo* ThumbnailInfo = GetSceneThumbnailInfo(TargetDistance);
-		check(ThumbnailInfo);
+	// The view rotation FThumbnailPreviewScene::CreateView builds from the orbit parameters. The orbit zoom
+	// only moves the view along its Z axis, so a point ends up at ViewRotation(Point + Origin) + (0, 0, OrbitZoom)
+	const FMatrix ViewRotationMatrix = FRotationMatrix(FRotator(0, OrbitYaw, 0))
+		* FRotationMatrix(FRotator(0, 0, OrbitPitch))
+		* FInverseRotationMatrix(FRotator(0, 90.f, 0))
+		* FMatrix(
+			FPlane(0, 0, 1, 0),
+			FPlane(1, 0, 0, 0),
+			FPlane(0, 1, 0, 0),
+			FPlane(0, 0, 0, 1));
+
+	// The view uses the same FOV for both axes, so a point is on screen when |X| and |Y| are below (Z + OrbitZoom) * tan(HalfFOV)
+	const float TanHalfFOV = FMath::Tan(HalfFOVRadians) * (1.f - FMath::Clamp(FramingMargin, 0.f, 0.9f));
+
+	float OrbitZoom = 0.f;
+	for (const FVector& Corner : GetPreviewActorBoxCorners())
+	{
+		const FVector ViewPosition = ViewRotationMatrix.TransformPosition(Corner + Origin);
+		const float RequiredZoom = FMath::Max(FMath::Abs(ViewPosition.X), FMath::Abs(ViewPosition.Y)) / TanHalfFOV - ViewPosition.Z;
 
-		OutOrigin = FVector(0, 0, -BoundsZOffset);
-		OutOrbitPitch = ThumbnailInfo->OrbitPitch;
-		OutOrbitYaw = ThumbnailInfo->OrbitYaw;
-		OutOrbitZoom = TargetDistance + ThumbnailInfo->OrbitZoom;
+		// Keep every corner in front of the near plane
+		OrbitZoom = FMath::Max3(OrbitZoom, RequiredZoom, 1.f - ViewPosition.Z);
 	}
+
+	FFramingCacheEntry& CachedFraming = FramingCache.FindOrAdd(OrbitYaw);
+	CachedFraming.Bounds = Bounds;
+	CachedFraming.HalfFOVRadians = HalfFOVRadians;
+	CachedFraming.OrbitPitch = OrbitPitch;
+	CachedFraming.OrbitYaw = OrbitYaw;
+	CachedFraming.FramingMargin = FramingMargin;
+	CachedFraming.OrbitZoom = OrbitZoom;
+
+	return OrbitZoom;
 }
 
-void FThumbnailExporterScene::SpawnPreviewActor(UClass* InClass)
+void FThumbnailExporterScene::SpawnPreviewActor(UClass* InClass, bool bVisualComponentsOnly)
 {
+	bFacePreviewMesh = false;
+
 	if (PreviewActor.IsStale())
 	{
 		PreviewActor = nullptr;
@@ -270,7 +811,7 @@ void FThumbnailExporterScene::SpawnPreviewActor(UClass* InClass)
 
 	if (PreviewActor.IsValid())
 	{
-		if (PreviewActor->GetClass() == InClass)
+		if (PreviewActorClass == InClass && bPreviewActorVisualComponentsOnly == bVisualComponentsOnly)
 		{
 			return;
 		}
@@ -278,6 +819,10 @@ void FThumbnailExporterScene::SpawnPreviewActor(UClass* InClass)
 		PreviewActor->Destroy();
 		PreviewActor = nullptr;
 	}
+
+	PreviewActorClass = InClass;
+	bPreviewActorVisualComponentsOnly = bVisualComponentsOnly;
+
 	if (InClass && !InClass->HasAnyClassFlags(CLASS_Deprecated | CLASS_Abstract))
 	{
 		// Create preview actor
@@ -285,7 +830,7 @@ void FThumbnailExporterScene::SpawnPreviewActor(UClass* InClass)
 		SpawnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
 		SpawnInfo.bNoFail = true;
 		SpawnInfo.ObjectFlags = RF_Transient;
-		PreviewActor = GetWorld()->SpawnActor<AActor>(InClass, SpawnInfo);
+		PreviewActor = bVisualComponentsOnly ? SpawnVisualComponents(InClass, SpawnInfo) : GetWorld()->SpawnActor<AActor>(InClass, SpawnInfo);
 
 		if (PreviewActor.IsValid())
 		{
@@ -298,25 +843,50 @@ void FThumbnailExporterScene::SpawnPreviewActor(UClass* InClass)
 	}
 }
 
-USceneThumbnailInfo* FThumbnailExporterScene::GetSceneThumbnailInfo(const float TargetDistance) const
+AActor* FThumbnailExporterScene::SpawnVisualComponents(UClass* InClass, const FActorSpawnParameters& SpawnInfo)
 {
-	UBlueprint* Blueprint = CurrentBlueprint.Get();
-	check(Blueprint);
+	TArray<FVisualComponentTemplate> VisualTemplates;
+	if (!GetVisualComponentTemplates(InClass, VisualTemplates))
+	{
+		// Something is attached to a socket only a spawned actor knows the transform of
+		return GetWorld()->SpawnActor<AActor>(InClass, SpawnInfo);
+	}
 
-	USceneThumbnailInfo* ThumbnailInfo = Cast<USceneThumbnailInfo>(Blueprint->ThumbnailInfo);
-	if (ThumbnailInfo)
+	AActor* Actor = GetWorld()->SpawnActor<AActor>(AActor::StaticClass(), SpawnInfo);
+	if (Actor == nullptr)
 	{
-		if (TargetDistance + ThumbnailInfo->OrbitZoom < 0)
-		{
-			ThumbnailInfo->OrbitZoom = -TargetDistance;
-		}
+		return nullptr;
 	}
-	else
+
+	USceneComponent* RootComponent = NewObject<USceneComponent>(Actor, NAME_None, RF_Transient);
+	Actor->SetRootComponent(RootComponent);
+	RootComponent->RegisterComponent();
+
+	for (const FVisualComponentTemplate& VisualTemplate : VisualTemplates)
 	{
-		ThumbnailInfo = USceneThumbnailInfo::StaticClass()->GetDefaultObject<USceneThumbnailInfo>();
+		UPrimitiveComponent* Component = NewObject<UPrimitiveComponent>(Actor, VisualTemplate.Template->GetClass(), NAME_None, RF_Transient, VisualTemplate.Template);
+
+		// Nothing but rendering is needed from the component
+		Component->BodyInstance.bSimulatePhysics = false;
+		Component->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		Component->SetGenerateOverlapEvents(false);
+		Component->PrimaryComponentTick.bCanEverTick = false;
+
+		Component->SetupAttachment(RootComponent);
+		Component->SetRelativeTransform(VisualTemplate.ComponentToActor);
+		Component->RegisterComponent();
+		Actor->AddInstanceComponent(Component);
 	}
 
-	return ThumbnailInfo;
+	return Actor;
+}
+
+USceneThumbnailInfo* FThumbnailExporterScene::GetSceneThumbnailInfo() const
+{
+	UBlueprint* Blueprint = CurrentBlueprint.Get();
+	check(Blueprint);
+
+	return Cast<USceneThumbnailInfo>(Blueprint->ThumbnailInfo);
 }
 
 FBoxSphereBounds FThumbnailExporterScene::GetPreviewActorBounds() const
@@ -340,6 +910,36 @@ FBoxSphereBounds FThumbnailExporterScene::GetPreviewActorBounds() const
 	return Bounds;
 }
 
+TArray<FVector> FThumbnailExporterScene::GetPreviewActorBoxCorners() const
+{
+	TArray<FVector> Corners;
+	if (PreviewActor.IsValid() && PreviewActor->GetRootComponent())
+	{
+		TArray<USceneComponent*> PreviewComponents;
+		PreviewActor->GetRootComponent()->GetChildrenComponents(true, PreviewComponents);
+		PreviewComponents.Add(PreviewActor->GetRootComponent());
+
+		for (USceneComponent* PreviewComponent : PreviewComponents)
+		{
+			if (IsValidComponentForVisualization(PreviewComponent))
+			{
+				// Local space bounds transformed by the component give an oriented box, which is tighter than the world space box for rotated components
+				const FBox LocalBox = PreviewComponent->CalcBounds(FTransform::Identity).GetBox();
+				const FTransform& ComponentTransform = PreviewComponent->GetComponentTransform();
+
+				FVector LocalCorners[8];
+				LocalBox.GetVertices(LocalCorners);
+				for (const FVector& LocalCorner : LocalCorners)
+				{
+					Corners.Add(ComponentTransform.TransformPosition(LocalCorner));
+				}
+			}
+		}
+	}
+
+	return Corners;
+}
+
 void FThumbnailExporterScene::ClearStaleActors()
 {
 	ULevel* Level = GetWorld()->GetCurrentLevel();
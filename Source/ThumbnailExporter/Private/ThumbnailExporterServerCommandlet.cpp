@@ -0,0 +1,330 @@
+// Copyright 2023 Big Cat Energising. All Rights Reserved.
+
+
+#include "ThumbnailExporterServerCommandlet.h"
+
+#include "ThumbnailExporter.h"
+#include "ThumbnailExporterBatch.h"
+#include "ThumbnailExporterSettings.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "AssetCompilingManager.h"
+#include "ShaderCompiler.h"
+#include "Common/TcpSocketBuilder.h"
+#include "Interfaces/IPv4/IPv4Endpoint.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "Containers/Ticker.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "JsonObjectConverter.h"
+
+static const int32 DefaultServerPort = 27815;
+
+// Longest request line accepted, in bytes. Clients that send more without a newline are disconnected, rather than buffered forever
+static const int32 DefaultMaxRequestBytes = 16 * 1024 * 1024;
+
+UThumbnailExporterServerCommandlet::UThumbnailExporterServerCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UThumbnailExporterServerCommandlet::Main(const FString& Params)
+{
+	int32 Port = DefaultServerPort;
+	FParse::Value(*Params, TEXT("Port="), Port);
+
+	int32 MaxRequestBytes = DefaultMaxRequestBytes;
+	FParse::Value(*Params, TEXT("MaxRequestBytes="), MaxRequestBytes);
+
+	// Requests refer to assets by path, so the registry has to know about all of them up front
+	FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get().SearchAllAssets(true);
+
+	// Only listen on the loopback address, the server is meant for jobs running on the same machine
+	const FIPv4Endpoint Endpoint(FIPv4Address(127, 0, 0, 1), Port);
+	FSocket* ListenSocket = FTcpSocketBuilder(TEXT("ThumbnailExporterServer"))
+		.AsReusable()
+		.BoundToEndpoint(Endpoint)
+		.Listening(1);
+	if (!ListenSocket)
+	{
+		UE_LOG(LogThumbnailExporter, Error, TEXT("Thumbnail export server could not listen on %s"), *Endpoint.ToString());
+		return 1;
+	}
+
+	UE_LOG(LogThumbnailExporter, Display, TEXT("Thumbnail export server listening on %s"), *Endpoint.ToString());
+
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	FSocket* ClientSocket = nullptr;
+	TArray<uint8> ReceivedBytes;
+
+	auto CloseClientSocket = [&ClientSocket, &ReceivedBytes, SocketSubsystem]()
+	{
+		ClientSocket->Close();
+		SocketSubsystem->DestroySocket(ClientSocket);
+		ClientSocket = nullptr;
+		ReceivedBytes.Reset();
+	};
+
+	const FTimespan WaitTime = FTimespan::FromMilliseconds(50);
+	double LastTickTime = FPlatformTime::Seconds();
+	while (!bShutdownRequested && !IsEngineExitRequested())
+	{
+		if (!ClientSocket)
+		{
+			bool bHasPendingConnection = false;
+			if (ListenSocket->WaitForPendingConnection(bHasPendingConnection, WaitTime) && bHasPendingConnection)
+			{
+				ClientSocket = ListenSocket->Accept(TEXT("ThumbnailExporterServerClient"));
+			}
+		}
+		else if (ClientSocket->Wait(ESocketWaitConditions::WaitForRead, WaitTime))
+		{
+			uint8 Buffer[4096];
+			int32 BytesRead = 0;
+			if (!ClientSocket->Recv(Buffer, sizeof(Buffer), BytesRead) || BytesRead == 0)
+			{
+				// The client disconnected
+				CloseClientSocket();
+			}
+			else
+			{
+				ReceivedBytes.Append(Buffer, BytesRead);
+
+				// Requests are newline terminated
+				int32 NewlineIndex = INDEX_NONE;
+				while (ClientSocket && ReceivedBytes.Find((uint8)'\n', NewlineIndex))
+				{
+					const FUTF8ToTCHAR Converted((const ANSICHAR*)ReceivedBytes.GetData(), NewlineIndex);
+					const FString Request = FString(Converted.Length(), Converted.Get()).TrimStartAndEnd();
+					ReceivedBytes.RemoveAt(0, NewlineIndex + 1);
+
+					if (Request.IsEmpty())
+					{
+						continue;
+					}
+
+					if (!SendResponse(ClientSocket, HandleRequest(Request)))
+					{
+						CloseClientSocket();
+					}
+
+					// The server stays up for many requests, so free the preview actors, render targets and anything else the request loaded
+					CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+				}
+
+				if (ClientSocket && ReceivedBytes.Num() > MaxRequestBytes)
+				{
+					UE_LOG(LogThumbnailExporter, Warning, TEXT("Closing the client connection, it sent a request longer than %d bytes"), MaxRequestBytes);
+					SendResponse(ClientSocket, MakeErrorResponse(FString::Printf(TEXT("The request is longer than %d bytes"), MaxRequestBytes)));
+					CloseClientSocket();
+				}
+			}
+		}
+
+		const double CurrentTime = FPlatformTime::Seconds();
+		TickIdle((float)(CurrentTime - LastTickTime));
+		LastTickTime = CurrentTime;
+	}
+
+	if (ClientSocket)
+	{
+		CloseClientSocket();
+	}
+	ListenSocket->Close();
+	SocketSubsystem->DestroySocket(ListenSocket);
+
+	UE_LOG(LogThumbnailExporter, Display, TEXT("Thumbnail export server stopped"));
+	return 0;
+}
+
+FString UThumbnailExporterServerCommandlet::HandleRequest(const FString& Request)
+{
+	TSharedPtr<FJsonObject> RequestObject;
+	if (!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Request), RequestObject) || !RequestObject.IsValid())
+	{
+		return MakeErrorResponse(TEXT("The request is not a JSON object"));
+	}
+
+	FString Command = TEXT("Export");
+	RequestObject->TryGetStringField(TEXT("Command"), Command);
+
+	if (Command == TEXT("Export"))
+	{
+		return HandleExportRequest(RequestObject.ToSharedRef());
+	}
+
+	if (Command == TEXT("Ping") || Command == TEXT("Shutdown"))
+	{
+		bShutdownRequested = Command == TEXT("Shutdown");
+
+		FString Response;
+		TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> JsonWriter = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Response);
+		JsonWriter->WriteObjectStart();
+		JsonWriter->WriteValue(TEXT("Success"), true);
+		JsonWriter->WriteObjectEnd();
+		JsonWriter->Close();
+		return Response;
+	}
+
+	return MakeErrorResponse(FString::Printf(TEXT("Unknown command '%s'"), *Command));
+}
+
+FString UThumbnailExporterServerCommandlet::HandleExportRequest(const TSharedRef<FJsonObject>& RequestObject)
+{
+	const double RequestStartTime = FPlatformTime::Seconds();
+
+	// Start from the named preset, or the first one, then apply the overrides from the request
+	const TArray<FThumbnailCreationPreset>& Presets = UThumbnailExporterSettings::Get()->ThumbnailCreationPresets;
+	FThumbnailCreationConfig CreationConfig;
+
+	FString PresetName;
+	if (RequestObject->TryGetStringField(TEXT("Preset"), PresetName))
+	{
+		const FThumbnailCreationPreset* Preset = Presets.FindByPredicate([&PresetName](const FThumbnailCreationPreset& Candidate) { return Candidate.MenuItemName.ToString() == PresetName; });
+		if (!Preset)
+		{
+			return MakeErrorResponse(FString::Printf(TEXT("There is no thumbnail creation preset named '%s'"), *PresetName));
+		}
+		CreationConfig = Preset->PresetConfig;
+	}
+	else if (Presets.Num() > 0)
+	{
+		CreationConfig = Presets[0].PresetConfig;
+	}
+
+	const TSharedPtr<FJsonObject>* ConfigObject = nullptr;
+	if (RequestObject->TryGetObjectField(TEXT("Config"), ConfigObject) && !FJsonObjectConverter::JsonObjectToUStruct(ConfigObject->ToSharedRef(), &CreationConfig))
+	{
+		return MakeErrorResponse(TEXT("The thumbnail creation config in the request is invalid"));
+	}
+
+	TArray<FString> AssetPaths;
+	if (!RequestObject->TryGetStringArrayField(TEXT("Assets"), AssetPaths))
+	{
+		return MakeErrorResponse(TEXT("The request has no Assets array"));
+	}
+
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+	TArray<FAssetData> Assets;
+	TArray<FString> SkippedAssets;
+	for (const FString& AssetPath : AssetPaths)
+	{
+		const FSoftObjectPath SoftObjectPath(AssetPath);
+#if ENGINE_MINOR_VERSION == 0
+		const FAssetData AssetData = AssetRegistry.GetAssetByObjectPath(SoftObjectPath.GetAssetPathName());
+#else
+		const FAssetData AssetData = AssetRegistry.GetAssetByObjectPath(SoftObjectPath.GetWithoutSubPath());
+#endif
+		if (AssetData.IsValid() && FThumbnailExporterModule::CanCreateThumbnail({ AssetData }))
+		{
+			Assets.Add(AssetData);
+		}
+		else
+		{
+			SkippedAssets.Add(AssetPath);
+		}
+	}
+
+	FThumbnailExporterBatch Batch(CreationConfig, Assets);
+	Batch.ExportAll();
+	const FThumbnailExportBatchReport& Report = Batch.GetReport();
+
+	const UEnum* StatusEnum = StaticEnum<EThumbnailExportStatus>();
+	const int32 NumStages = (int32)EThumbnailExportStage::Num;
+
+	FString Response;
+	TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> JsonWriter = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Response);
+
+	auto WriteJsonStages = [&JsonWriter, NumStages](const FThumbnailExportStageTimings& Timings)
+	{
+		JsonWriter->WriteObjectStart(TEXT("Stages"));
+		for (int32 StageIndex = 0; StageIndex < NumStages; ++StageIndex)
+		{
+			JsonWriter->WriteValue(FThumbnailExportStageTimings::GetStageName((EThumbnailExportStage)StageIndex), Timings.Seconds[StageIndex]);
+		}
+		JsonWriter->WriteObjectEnd();
+	};
+
+	JsonWriter->WriteObjectStart();
+	JsonWriter->WriteValue(TEXT("Success"), Report.NumFailed == 0 && SkippedAssets.Num() == 0);
+	JsonWriter->WriteValue(TEXT("NumExported"), Report.NumExported);
+	JsonWriter->WriteValue(TEXT("NumFailed"), Report.NumFailed);
+	JsonWriter->WriteValue(TEXT("NumSkipped"), Report.NumSkipped);
+	JsonWriter->WriteValue(TEXT("SkippedAssets"), SkippedAssets);
+	JsonWriter->WriteValue(TEXT("AtlasPagePaths"), Report.AtlasPagePaths);
+	JsonWriter->WriteValue(TEXT("ManifestPath"), Report.ManifestPath);
+	JsonWriter->WriteValue(TEXT("TimingReportPath"), Report.TimingReportPath);
+	JsonWriter->WriteValue(TEXT("TotalSeconds"), Report.TotalSeconds);
+	JsonWriter->WriteValue(TEXT("RequestSeconds"), FPlatformTime::Seconds() - RequestStartTime);
+	WriteJsonStages(Report.Timings);
+
+	JsonWriter->WriteArrayStart(TEXT("Results"));
+	for (const FThumbnailExportResult& Result : Report.Results)
+	{
+		JsonWriter->WriteObjectStart();
+		JsonWriter->WriteValue(TEXT("Asset"), Result.Asset.GetObjectPathString());
+		JsonWriter->WriteValue(TEXT("Status"), StatusEnum->GetNameStringByValue((int64)Result.Status));
+		JsonWriter->WriteValue(TEXT("ThumbnailPath"), Result.ThumbnailPath);
+		if (Result.AtlasPage != INDEX_NONE)
+		{
+			JsonWriter->WriteValue(TEXT("AtlasPage"), Result.AtlasPage);
+		}
+		JsonWriter->WriteValue(TEXT("NumTriangles"), Result.NumTriangles);
+		JsonWriter->WriteValue(TEXT("TotalSeconds"), Result.Timings.GetTotalSeconds());
+		WriteJsonStages(Result.Timings);
+		JsonWriter->WriteObjectEnd();
+	}
+	JsonWriter->WriteArrayEnd();
+	JsonWriter->WriteObjectEnd();
+	JsonWriter->Close();
+
+	UE_LOG(LogThumbnailExporter, Display, TEXT("Handled export request for %d assets in %.2f s"), AssetPaths.Num(), FPlatformTime::Seconds() - RequestStartTime);
+	return Response;
+}
+
+void UThumbnailExporterServerCommandlet::TickIdle(float DeltaTime)
+{
+	FTSTicker::GetCoreTicker().Tick(DeltaTime);
+
+	if (GShaderCompilingManager)
+	{
+		GShaderCompilingManager->ProcessAsyncResults(true, false);
+	}
+	FAssetCompilingManager::Get().ProcessAsyncTasks(true);
+}
+
+bool UThumbnailExporterServerCommandlet::SendResponse(FSocket* Socket, const FString& Response)
+{
+	const FTCHARToUTF8 Converted(*(Response + TEXT("\n")));
+	const uint8* Data = (const uint8*)Converted.Get();
+	int32 BytesRemaining = Converted.Length();
+	while (BytesRemaining > 0)
+	{
+		int32 BytesSent = 0;
+		if (!Socket->Send(Data, BytesRemaining, BytesSent))
+		{
+			return false;
+		}
+		Data += BytesSent;
+		BytesRemaining -= BytesSent;
+	}
+	return true;
+}
+
+FString UThumbnailExporterServerCommandlet::MakeErrorResponse(const FString& Error)
+{
+	UE_LOG(LogThumbnailExporter, Warning, TEXT("Thumbnail export server request failed: %s"), *Error);
+
+	FString Response;
+	TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> JsonWriter = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Response);
+	JsonWriter->WriteObjectStart();
+	JsonWriter->WriteValue(TEXT("Success"), false);
+	JsonWriter->WriteValue(TEXT("Error"), Error);
+	JsonWriter->WriteObjectEnd();
+	JsonWriter->Close();
+	return Response;
+}
@@ -0,0 +1,79 @@
+// Copyright 2023 Big Cat Energising. All Rights Reserved.
+
+
+#include "ThumbnailExporterSkyLightComponent.h"
+
+#include "Engine/TextureCube.h"
+#include "TextureCompiler.h"
+
+// Every registered sky light that holds a capture, used to share captures between thumbnail scenes
+static TArray<TWeakObjectPtr<UThumbnailExporterSkyLightComponent>> CapturedSkyLights;
+
+void UThumbnailExporterSkyLightComponent::CaptureOnce()
+{
+	if (bHasCapture)
+	{
+		return;
+	}
+
+	CapturedSkyLights.RemoveAll([](const TWeakObjectPtr<UThumbnailExporterSkyLightComponent>& CapturedSkyLight) { return !CapturedSkyLight.IsValid(); });
+
+	for (const TWeakObjectPtr<UThumbnailExporterSkyLightComponent>& CapturedSkyLight : CapturedSkyLights)
+	{
+		const UThumbnailExporterSkyLightComponent* Other = CapturedSkyLight.Get();
+		if (Other != this && HasSameCaptureSettings(*Other))
+		{
+			// The processed cubemap is ref counted, so all the scenes render with the same texture
+			ProcessedSkyTexture = Other->ProcessedSkyTexture;
+			IrradianceEnvironmentMap = Other->IrradianceEnvironmentMap;
+			AverageBrightness = Other->AverageBrightness;
+			bHasCapture = true;
+			CapturedSkyLights.Add(this);
+
+			// Recreate the proxy so it picks up the copied capture
+			MarkRenderStateDirty();
+			DoDeferredRenderUpdates_Concurrent();
+			return;
+		}
+	}
+
+	if (UTexture* CubemapTexture = Cubemap)
+	{
+		FTextureCompilingManager::Get().FinishCompilation({ CubemapTexture });
+	}
+
+	SetCaptureIsDirty();
+	USkyLightComponent::UpdateSkyCaptureContents(GetWorld());
+	DoDeferredRenderUpdates_Concurrent();
+
+	// The irradiance is written by the render thread, it has to be there before another sky light copies it
+	FlushRenderingCommands();
+
+	bHasCapture = true;
+	CapturedSkyLights.Add(this);
+}
+
+void UThumbnailExporterSkyLightComponent::OnUnregister()
+{
+	Super::OnUnregister();
+
+	// Whatever the sky light is registered with next has to capture again
+	bHasCapture = false;
+	CapturedSkyLights.Remove(this);
+}
+
+bool UThumbnailExporterSkyLightComponent::HasSameCaptureSettings(const UThumbnailExporterSkyLightComponent& Other) const
+{
+	// Captured scenes depend on what's in the scene, only the specified cubemap captures are the same everywhere
+	return Other.bHasCapture
+		&& Other.ProcessedSkyTexture.IsValid()
+		&& SourceType == SLS_SpecifiedCubemap
+		&& Other.SourceType == SourceType
+		&& Other.Cubemap == Cubemap
+		&& Other.SourceCubemapAngle == SourceCubemapAngle
+		&& Other.CubemapResolution == CubemapResolution
+		&& Other.SkyDistanceThreshold == SkyDistanceThreshold
+		&& Other.bLowerHemisphereIsBlack == bLowerHemisphereIsBlack
+		&& Other.LowerHemisphereColor == LowerHemisphereColor
+		&& Other.GetWorld()->GetFeatureLevel() == GetWorld()->GetFeatureLevel();
+}
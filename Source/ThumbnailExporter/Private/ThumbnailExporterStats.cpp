@@ -0,0 +1,132 @@
+// Copyright 2023 Big Cat Energising. All Rights Reserved.
+
+
+#include "ThumbnailExporterStats.h"
+
+DEFINE_STAT(STAT_ThumbnailExporter_DerivedDataCache);
+DEFINE_STAT(STAT_ThumbnailExporter_AssetLoad);
+DEFINE_STAT(STAT_ThumbnailExporter_ShaderCompile);
+DEFINE_STAT(STAT_ThumbnailExporter_TextureStreaming);
+DEFINE_STAT(STAT_ThumbnailExporter_SceneSetup);
+DEFINE_STAT(STAT_ThumbnailExporter_RenderColor);
+DEFINE_STAT(STAT_ThumbnailExporter_RenderAlpha);
+DEFINE_STAT(STAT_ThumbnailExporter_FlushRendering);
+DEFINE_STAT(STAT_ThumbnailExporter_Readback);
+DEFINE_STAT(STAT_ThumbnailExporter_AlphaMerge);
+DEFINE_STAT(STAT_ThumbnailExporter_ImageProcessing);
+DEFINE_STAT(STAT_ThumbnailExporter_Encode);
+DEFINE_STAT(STAT_ThumbnailExporter_EncodeWait);
+DEFINE_STAT(STAT_ThumbnailExporter_TextureBuild);
+DEFINE_STAT(STAT_ThumbnailExporter_SavePackage);
+DEFINE_STAT(STAT_ThumbnailExporter_AtlasPacking);
+DEFINE_STAT(STAT_ThumbnailExporter_Manifest);
+
+DEFINE_STAT(STAT_ThumbnailExporter_RenderTargetMemory);
+DEFINE_STAT(STAT_ThumbnailExporter_PendingThumbnailMemory);
+DEFINE_STAT(STAT_ThumbnailExporter_AtlasImageMemory);
+
+UE_TRACE_CHANNEL_DEFINE(ThumbnailExporterChannel);
+
+FThumbnailExportStageTimings* FThumbnailExportStageScope::ActiveTimings = nullptr;
+FThumbnailExportStageScope* FThumbnailExportStageScope::CurrentScope = nullptr;
+
+FThumbnailExportStageTimings& FThumbnailExportStageTimings::operator+=(const FThumbnailExportStageTimings& Other)
+{
+	for (int32 i = 0; i < (int32)EThumbnailExportStage::Num; ++i)
+	{
+		Seconds[i] += Other.Seconds[i];
+	}
+	return *this;
+}
+
+double FThumbnailExportStageTimings::GetTotalSeconds() const
+{
+	double TotalSeconds = 0.0;
+	for (int32 i = 0; i < (int32)EThumbnailExportStage::Num; ++i)
+	{
+		TotalSeconds += Seconds[i];
+	}
+	return TotalSeconds;
+}
+
+const TCHAR* FThumbnailExportStageTimings::GetStageName(EThumbnailExportStage Stage)
+{
+	switch (Stage)
+	{
+	case EThumbnailExportStage::DerivedDataCache:
+		return TEXT("DerivedDataCache");
+	case EThumbnailExportStage::AssetLoad:
+		return TEXT("AssetLoad");
+	case EThumbnailExportStage::ShaderCompile:
+		return TEXT("ShaderCompile");
+	case EThumbnailExportStage::TextureStreaming:
+		return TEXT("TextureStreaming");
+	case EThumbnailExportStage::SceneSetup:
+		return TEXT("SceneSetup");
+	case EThumbnailExportStage::RenderColor:
+		return TEXT("RenderColor");
+	case EThumbnailExportStage::RenderAlpha:
+		return TEXT("RenderAlpha");
+	case EThumbnailExportStage::FlushRendering:
+		return TEXT("FlushRendering");
+	case EThumbnailExportStage::Readback:
+		return TEXT("Readback");
+	case EThumbnailExportStage::AlphaMerge:
+		return TEXT("AlphaMerge");
+	case EThumbnailExportStage::ImageProcessing:
+		return TEXT("ImageProcessing");
+	case EThumbnailExportStage::Encode:
+		return TEXT("Encode");
+	case EThumbnailExportStage::EncodeWait:
+		return TEXT("EncodeWait");
+	case EThumbnailExportStage::TextureBuild:
+		return TEXT("TextureBuild");
+	case EThumbnailExportStage::SavePackage:
+		return TEXT("SavePackage");
+	case EThumbnailExportStage::AtlasPacking:
+		return TEXT("AtlasPacking");
+	case EThumbnailExportStage::Manifest:
+		return TEXT("Manifest");
+	default:
+		return TEXT("Unknown");
+	}
+}
+
+FThumbnailExportStageScope::FThumbnailExportStageScope(EThumbnailExportStage InStage)
+	: Stage(InStage)
+	, Timings(IsInGameThread() ? ActiveTimings : nullptr)
+	, ParentScope(nullptr)
+	, StartTime(0.0)
+{
+	if (Timings == nullptr)
+	{
+		return;
+	}
+
+	StartTime = FPlatformTime::Seconds();
+
+	// Pause the outer stage while this one runs
+	ParentScope = CurrentScope;
+	if (ParentScope)
+	{
+		(*ParentScope->Timings)[ParentScope->Stage] += StartTime - ParentScope->StartTime;
+	}
+	CurrentScope = this;
+}
+
+FThumbnailExportStageScope::~FThumbnailExportStageScope()
+{
+	if (Timings == nullptr)
+	{
+		return;
+	}
+
+	const double EndTime = FPlatformTime::Seconds();
+	(*Timings)[Stage] += EndTime - StartTime;
+
+	CurrentScope = ParentScope;
+	if (ParentScope)
+	{
+		ParentScope->StartTime = EndTime;
+	}
+}
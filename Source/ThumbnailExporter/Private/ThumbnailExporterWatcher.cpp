@@ -0,0 +1,300 @@
+// Copyright 2023 Big Cat Energising. All Rights Reserved.
+
+
+#include "ThumbnailExporterWatcher.h"
+
+#include "ThumbnailExporter.h"
+#include "ThumbnailExporterQueue.h"
+#include "ThumbnailExporterSettings.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Editor.h"
+#include "Subsystems/ImportSubsystem.h"
+#include "UObject/ObjectSaveContext.h"
+
+FThumbnailExporterWatcher::FThumbnailExporterWatcher()
+{
+	UPackage::PackageSavedWithContextEvent.AddRaw(this, &FThumbnailExporterWatcher::OnPackageSaved);
+
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+	AssetRegistry.OnAssetAdded().AddRaw(this, &FThumbnailExporterWatcher::OnAssetRegistryChanged);
+	AssetRegistry.OnAssetRemoved().AddRaw(this, &FThumbnailExporterWatcher::OnAssetRegistryChanged);
+	AssetRegistry.OnAssetRenamed().AddRaw(this, &FThumbnailExporterWatcher::OnAssetRenamed);
+
+	UThumbnailExporterSettings::Get()->OnSettingChanged().AddRaw(this, &FThumbnailExporterWatcher::OnSettingsChanged);
+
+	// The import subsystem doesn't exist until the editor engine has been created
+	if (GEditor)
+	{
+		RegisterReimportDelegate();
+	}
+	else
+	{
+		PostEngineInitHandle = FCoreDelegates::OnPostEngineInit.AddRaw(this, &FThumbnailExporterWatcher::RegisterReimportDelegate);
+	}
+}
+
+FThumbnailExporterWatcher::~FThumbnailExporterWatcher()
+{
+	UPackage::PackageSavedWithContextEvent.RemoveAll(this);
+	FCoreDelegates::OnPostEngineInit.Remove(PostEngineInitHandle);
+
+	if (UObjectInitialized())
+	{
+		UThumbnailExporterSettings::Get()->OnSettingChanged().RemoveAll(this);
+	}
+
+	if (FAssetRegistryModule* AssetRegistryModule = FModuleManager::GetModulePtr<FAssetRegistryModule>("AssetRegistry"))
+	{
+		IAssetRegistry& AssetRegistry = AssetRegistryModule->Get();
+		AssetRegistry.OnAssetAdded().RemoveAll(this);
+		AssetRegistry.OnAssetRemoved().RemoveAll(this);
+		AssetRegistry.OnAssetRenamed().RemoveAll(this);
+	}
+
+	if (GEditor)
+	{
+		if (UImportSubsystem* ImportSubsystem = GEditor->GetEditorSubsystem<UImportSubsystem>())
+		{
+			ImportSubsystem->OnAssetReimport.RemoveAll(this);
+		}
+	}
+}
+
+void FThumbnailExporterWatcher::Tick(float DeltaTime)
+{
+	if (FPlatformTime::Seconds() - LastChangeTime >= UThumbnailExporterSettings::Get()->ReexportDebounceSeconds)
+	{
+		ReexportChangedPackages();
+	}
+}
+
+TStatId FThumbnailExporterWatcher::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(FThumbnailExporterWatcher, STATGROUP_ThumbnailExporter);
+}
+
+void FThumbnailExporterWatcher::RegisterReimportDelegate()
+{
+	FCoreDelegates::OnPostEngineInit.Remove(PostEngineInitHandle);
+	PostEngineInitHandle.Reset();
+
+	if (GEditor)
+	{
+		if (UImportSubsystem* ImportSubsystem = GEditor->GetEditorSubsystem<UImportSubsystem>())
+		{
+			ImportSubsystem->OnAssetReimport.AddRaw(this, &FThumbnailExporterWatcher::OnAssetReimported);
+		}
+	}
+}
+
+void FThumbnailExporterWatcher::OnPackageSaved(const FString& PackageFilename, UPackage* Package, FObjectPostSaveContext ObjectSaveContext)
+{
+	// Autosaves and cooks don't change the asset as far as the user is concerned
+	if (ObjectSaveContext.IsProceduralSave() || (ObjectSaveContext.GetSaveFlags() & SAVE_FromAutosave) != 0)
+	{
+		return;
+	}
+
+	AddChangedPackage(Package->GetFName());
+}
+
+void FThumbnailExporterWatcher::OnAssetReimported(UObject* Asset)
+{
+	AddChangedPackage(Asset->GetOutermost()->GetFName());
+}
+
+void FThumbnailExporterWatcher::OnAssetRegistryChanged(const FAssetData& Asset)
+{
+	InvalidateReverseIndex(Asset.PackageName);
+	InvalidateReferencers({ Asset.PackageName });
+}
+
+void FThumbnailExporterWatcher::OnAssetRenamed(const FAssetData& Asset, const FString& OldObjectPath)
+{
+	const FName OldPackageName(*FPackageName::ObjectPathToPackageName(OldObjectPath));
+	InvalidateReverseIndex(Asset.PackageName);
+	InvalidateReverseIndex(OldPackageName);
+	InvalidateReferencers({ Asset.PackageName, OldPackageName });
+}
+
+void FThumbnailExporterWatcher::OnSettingsChanged(UObject* Settings, FPropertyChangedEvent& PropertyChangedEvent)
+{
+	// Only the presets decide where thumbnails are
+	if (PropertyChangedEvent.GetMemberPropertyName() == GET_MEMBER_NAME_CHECKED(UThumbnailExporterSettings, ThumbnailCreationPresets))
+	{
+		ReverseIndex.Reset();
+		ReverseIndexPackages.Reset();
+	}
+}
+
+void FThumbnailExporterWatcher::AddChangedPackage(FName PackageName)
+{
+	if (!UThumbnailExporterSettings::Get()->bReexportThumbnailsOnSave || IsRunningCommandlet())
+	{
+		return;
+	}
+
+	ChangedPackages.Add(PackageName);
+	LastChangeTime = FPlatformTime::Seconds();
+}
+
+void FThumbnailExporterWatcher::ReexportChangedPackages()
+{
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+	const TArray<FThumbnailCreationPreset>& Presets = UThumbnailExporterSettings::Get()->ThumbnailCreationPresets;
+
+	InvalidateReferencers(ChangedPackages);
+
+	TSet<FName> AffectedPackages;
+	CollectAffectedPackages(ChangedPackages, AffectedPackages);
+	ChangedPackages.Reset();
+
+	// Preset index -> assets to re-export with it
+	TMap<int32, TArray<FAssetData>> AssetsPerPreset;
+	for (FName PackageName : AffectedPackages)
+	{
+		TArray<FAssetData> PackageAssets;
+		AssetRegistry.GetAssetsByPackageName(PackageName, PackageAssets);
+		for (const FAssetData& Asset : PackageAssets)
+		{
+			// Checking for an exported thumbnail doesn't load the asset, so do that before CanCreateThumbnail
+			const TArray<int32>& ExportedPresets = FindExportedPresets(Asset);
+			if (ExportedPresets.Num() == 0 || !FThumbnailExporterModule::CanCreateThumbnail({ Asset }))
+			{
+				continue;
+			}
+
+			for (int32 PresetIndex : ExportedPresets)
+			{
+				AssetsPerPreset.FindOrAdd(PresetIndex).Add(Asset);
+			}
+		}
+	}
+
+	for (const TPair<int32, TArray<FAssetData>>& PresetAssets : AssetsPerPreset)
+	{
+		UE_LOG(LogThumbnailExporter, Log, TEXT("Re-exporting %d thumbnails with preset %s"), PresetAssets.Value.Num(), *Presets[PresetAssets.Key].MenuItemName.ToString());
+		FThumbnailExporterModule::GetExportQueue().Submit(Presets[PresetAssets.Key].PresetConfig, PresetAssets.Value);
+	}
+}
+
+void FThumbnailExporterWatcher::CollectAffectedPackages(const TSet<FName>& InChangedPackages, TSet<FName>& OutAffectedPackages)
+{
+	TArray<FName> PackagesToVisit = InChangedPackages.Array();
+	OutAffectedPackages.Append(InChangedPackages);
+
+	while (PackagesToVisit.Num() > 0)
+	{
+		const FName PackageName = PackagesToVisit.Pop();
+		for (FName Referencer : GetReferencers(PackageName))
+		{
+			bool bAlreadyVisited = false;
+			OutAffectedPackages.Add(Referencer, &bAlreadyVisited);
+			if (!bAlreadyVisited)
+			{
+				PackagesToVisit.Add(Referencer);
+			}
+		}
+	}
+}
+
+const TArray<FName>& FThumbnailExporterWatcher::GetReferencers(FName PackageName)
+{
+	if (const TArray<FName>* CachedReferencers = ReferencersCache.Find(PackageName))
+	{
+		return *CachedReferencers;
+	}
+
+	// Soft references don't change what an asset looks like when it is rendered
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+	TArray<FName>& Referencers = ReferencersCache.Add(PackageName);
+	AssetRegistry.GetReferencers(PackageName, Referencers, UE::AssetRegistry::EDependencyCategory::Package, UE::AssetRegistry::EDependencyQuery::Hard);
+	for (FName Referencer : Referencers)
+	{
+		ReferencersCacheEntries.AddUnique(Referencer, PackageName);
+	}
+	return Referencers;
+}
+
+void FThumbnailExporterWatcher::InvalidateReferencers(const TSet<FName>& InChangedPackages)
+{
+	if (ReferencersCache.Num() == 0)
+	{
+		return;
+	}
+
+	// A changed package may have started referencing new packages...
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+	for (FName PackageName : InChangedPackages)
+	{
+		TArray<FName> Dependencies;
+		AssetRegistry.GetDependencies(PackageName, Dependencies, UE::AssetRegistry::EDependencyCategory::Package, UE::AssetRegistry::EDependencyQuery::Hard);
+		for (FName Dependency : Dependencies)
+		{
+			ReferencersCache.Remove(Dependency);
+		}
+	}
+
+	// ...or stopped referencing packages it used to
+	for (FName PackageName : InChangedPackages)
+	{
+		TArray<FName> ReferencedPackages;
+		ReferencersCacheEntries.MultiFind(PackageName, ReferencedPackages);
+		ReferencersCacheEntries.Remove(PackageName);
+		for (FName ReferencedPackage : ReferencedPackages)
+		{
+			ReferencersCache.Remove(ReferencedPackage);
+		}
+	}
+}
+
+const TArray<int32>& FThumbnailExporterWatcher::FindExportedPresets(const FAssetData& Asset)
+{
+	const FSoftObjectPath AssetPath = Asset.ToSoftObjectPath();
+	if (const TArray<int32>* ExportedPresets = ReverseIndex.Find(AssetPath))
+	{
+		return *ExportedPresets;
+	}
+
+	TArray<int32>& ExportedPresets = ReverseIndex.Add(AssetPath);
+	ReverseIndexPackages.AddUnique(Asset.PackageName, AssetPath);
+	const TArray<FThumbnailCreationPreset>& Presets = UThumbnailExporterSettings::Get()->ThumbnailCreationPresets;
+	for (int32 PresetIndex = 0; PresetIndex < Presets.Num(); ++PresetIndex)
+	{
+		const FThumbnailCreationConfig& CreationConfig = Presets[PresetIndex].PresetConfig;
+
+		// Every asset exported with a fixed filename writes to the same texture, so it can't be traced back to an asset
+		if (CreationConfig.bOverrideThumbnailFilename)
+		{
+			continue;
+		}
+
+		FString Path;
+		FString Filename;
+		if (!FThumbnailExporterModule::GetThumbnailAssetPathAndFilename(CreationConfig, Asset, Path, Filename))
+		{
+			continue;
+		}
+
+		// Exporting or deleting the thumbnail adds or removes its package, which invalidates the entry
+		const FString ThumbnailPackageName = Path / Filename;
+		ReverseIndexPackages.AddUnique(FName(*ThumbnailPackageName), AssetPath);
+		if (FPackageName::DoesPackageExist(ThumbnailPackageName))
+		{
+			ExportedPresets.Add(PresetIndex);
+		}
+	}
+
+	return ExportedPresets;
+}
+
+void FThumbnailExporterWatcher::InvalidateReverseIndex(FName PackageName)
+{
+	TArray<FSoftObjectPath> AssetPaths;
+	ReverseIndexPackages.MultiFind(PackageName, AssetPaths);
+	ReverseIndexPackages.Remove(PackageName);
+	for (const FSoftObjectPath& AssetPath : AssetPaths)
+	{
+		ReverseIndex.Remove(AssetPath);
+	}
+}
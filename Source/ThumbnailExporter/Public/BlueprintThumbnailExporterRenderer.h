@@ -10,6 +10,14 @@
 struct FThumbnailCreationConfig;
 class FThumbnailExporterScene;
 
+// A frame that looks the same as an earlier one, so it is copied from that frame instead of being rendered again
+struct FThumbnailFrameCopy
+{
+	FIntPoint SourcePosition;
+	FIntPoint DestPosition;
+	FIntPoint Size;
+};
+
 struct FThumbnailCreationParams
 {
 	FThumbnailCreationParams(FThumbnailCreationConfig& InCreationConfig)
@@ -27,6 +35,8 @@ struct FThumbnailCreationParams
 	bool bAdditionalViewFamily;
 	bool bIsAlpha; // If true, then we are rendering out the alpha 
 	FPreCreateThumbnail CreationDelegate;
+	int64 NumTriangles = 0; // Set by DrawThumbnailWithConfig to the number of triangles in the rendered LODs of the asset
+	TArray<FThumbnailFrameCopy> FrameCopies; // Set by DrawThumbnailWithConfig to the frames the caller has to copy after reading back the render target
 
 	FVector2D GetThumbnailSize() const
 	{
@@ -55,6 +65,9 @@ public:
 #endif
 
 protected:
+	// Draws the material straight onto the canvas as a tile in every frame, without rendering the scene
+	static void DrawMaterialTiles(FThumbnailCreationParams& CreationParams, class UMaterialInterface* Material);
+
 	FThumbnailExporterScene& GetThumbnailScene(const FThumbnailCreationConfig& CreationConfig);
 	TArray<FThumbnailExporterScene*> ThumbnailScenes;
 };
@@ -8,6 +8,11 @@
 
 struct FAssetData;
 struct FThumbnailCreationConfig;
+struct FThumbnailExportBatchReport;
+class FThumbnailExporterQueue;
+class FThumbnailExporterWatcher;
+
+THUMBNAILEXPORTER_API DECLARE_LOG_CATEGORY_EXTERN(LogThumbnailExporter, Log, All);
 
 class FThumbnailExporterModule : public IModuleInterface
 {
@@ -21,6 +26,12 @@ public:
 	// Returns true if the creation was succesful
 	static bool ExportThumbnail(const FThumbnailCreationConfig& CreationConfig, const FAssetData& Asset, FString& ThumbnailPath, const FPreCreateThumbnail& CreationDelegate = {});
 
+	// Exports the thumbnails of all of the assets, rendering each thumbnail while the previous one is encoded and saved
+	static FThumbnailExportBatchReport ExportThumbnails(const FThumbnailCreationConfig& CreationConfig, const TArray<FAssetData>& Assets, const FPreCreateThumbnail& CreationDelegate = {});
+
+	// Queue that exports thumbnails in the background while the editor keeps running
+	static FThumbnailExporterQueue& GetExportQueue();
+
 	// Returns true if a thumbnail can be created for the asset(s)
 	static bool CanCreateThumbnail(const TArray<FAssetData>& Assets);
 
@@ -29,14 +40,28 @@ public:
 	static bool GetThumbnailAssetPathAndFilename(const FThumbnailCreationConfig& CreationConfig, const FAssetData& Asset, FString& Path, FString& Filename);
 
 protected:
+	friend class FThumbnailExporterBatch;
+
 	FDelegateHandle ContentBrowserExtenderDelegateHandle;
 
+	TUniquePtr<FThumbnailExporterQueue> ExportQueue;
+
+	// Re-exports thumbnails when their assets are saved, if enabled in the settings
+	TUniquePtr<FThumbnailExporterWatcher> Watcher;
+
 	void AddContentBrowserContextMenuExtender();
 	void RemoveContentBrowserContextMenuExtender() const;
 
 	static TSharedRef<FExtender> OnExtendContentBrowserAssetSelectionMenu(const TArray<FAssetData>& SelectedAssets);
 
+	// Filters out the assets that a thumbnail can't be created for
+	static TArray<FAssetData> GetExportableAssets(const TArray<FAssetData>& Assets);
+
 	static void ExecuteSaveThumbnailAsTexture(FMenuBuilder& MenuBuilder, const TArray<FAssetData> SelectedAssets);
 
 	static void CreateThumbnailNotification(UTexture2D* NewTexture);
+
+	// Warns if the runtime settings' naming rules don't match the filename settings of any preset, since the game wouldn't find the thumbnails
+	static void ValidateRuntimeNamingRules();
+	void OnSettingsChanged(UObject* Settings, struct FPropertyChangedEvent& PropertyChangedEvent);
 };
@@ -0,0 +1,52 @@
+// Copyright 2023 Big Cat Energising. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/CancellableAsyncAction.h"
+#include "ThumbnailExporterBatch.h"
+#include "ThumbnailExporterAsyncExport.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnAsyncThumbnailExported, const FThumbnailExportResult&, Result);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnAsyncThumbnailExportCompleted, const FThumbnailExportBatchReport&, Report);
+
+/**
+ * Exports the thumbnails of a list of assets through the export queue without blocking the caller.
+ * In Blueprint this is a latent node, from Python use UThumbnailExporterBlueprintFunctionLibrary::StartThumbnailExport
+ * and bind the delegates on the returned handle.
+ */
+UCLASS()
+class THUMBNAILEXPORTER_API UThumbnailExporterAsyncExport : public UCancellableAsyncAction
+{
+	GENERATED_BODY()
+
+public:
+	// Called for each asset once its thumbnail has been written. Atlased thumbnails are written when the atlas pages are, at the end of the export
+	UPROPERTY(BlueprintAssignable, Category = "Thumbnail Exporter")
+		FOnAsyncThumbnailExported OnThumbnailExported;
+
+	// Called once every asset has been exported, or the export was cancelled
+	UPROPERTY(BlueprintAssignable, Category = "Thumbnail Exporter")
+		FOnAsyncThumbnailExportCompleted OnCompleted;
+
+	// Queues the export of the thumbnails of the assets. The export runs in the background while the editor keeps ticking
+	UFUNCTION(BlueprintCallable, Category = "Thumbnail Exporter", meta = (BlueprintInternalUseOnly = "true", AutoCreateRefTerm = "CreationDelegate"))
+		static UThumbnailExporterAsyncExport* ExportThumbnailsAsync(const FThumbnailCreationConfig& CreationConfig, const TArray<FAssetData>& Assets, const FPreCreateThumbnail& CreationDelegate);
+
+	virtual void Activate() override;
+	virtual void Cancel() override;
+	virtual bool IsActive() const override;
+
+protected:
+	void HandleThumbnailExported(const FThumbnailExportResult& Result);
+	void HandleJobFinished(const FThumbnailExportBatchReport& Report);
+
+	FThumbnailCreationConfig CreationConfig;
+	TArray<FAssetData> Assets;
+	FPreCreateThumbnail CreationDelegate;
+
+	int32 JobId = INDEX_NONE;
+
+	// Set once the job has finished or been cancelled, after which the action is ready to be destroyed and must not be again
+	bool bFinished = false;
+};
@@ -0,0 +1,48 @@
+// Copyright 2023 Big Cat Energising. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Skyline bottom-left rectangle packer. Packs rectangles into as many fixed size pages as needed
+ */
+class THUMBNAILEXPORTER_API FThumbnailExporterAtlasPacker
+{
+public:
+	FThumbnailExporterAtlasPacker(int32 InPageSizeX, int32 InPageSizeY, int32 InPadding);
+
+	// Finds a spot for a rectangle, adding a new page if it doesn't fit in any of the existing pages.
+	// Returns false if the rectangle is bigger than a page
+	bool AddRect(int32 SizeX, int32 SizeY, int32& OutPage, FIntPoint& OutPosition);
+
+	int32 GetNumPages() const { return Pages.Num(); }
+
+protected:
+	// A horizontal segment of the skyline, spanning [X, X + Width) at height Y
+	struct FSkylineNode
+	{
+		int32 X;
+		int32 Y;
+		int32 Width;
+	};
+
+	struct FPage
+	{
+		TArray<FSkylineNode> Skyline;
+	};
+
+	// Finds the lowest position on the page's skyline where the rectangle fits. Returns the index of the skyline node it starts at, or INDEX_NONE
+	int32 FindPosition(const FPage& Page, int32 SizeX, int32 SizeY, FIntPoint& OutPosition) const;
+
+	// Raises the skyline under a rectangle placed at Position
+	void AddToSkyline(FPage& Page, int32 NodeIndex, const FIntPoint& Position, int32 SizeX, int32 SizeY);
+
+	FPage& AddPage();
+
+	int32 PageSizeX;
+	int32 PageSizeY;
+	int32 Padding;
+
+	TArray<FPage> Pages;
+};
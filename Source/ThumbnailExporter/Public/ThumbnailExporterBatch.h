@@ -0,0 +1,265 @@
+// Copyright 2023 Big Cat Energising. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AssetRegistry/AssetData.h"
+#include "ThumbnailExporterSettings.h"
+#include "ThumbnailExporterBlueprintFunctionLibrary.h"
+#include "ThumbnailExporterStats.h"
+#include "ThumbnailExporterCache.h"
+#include "ThumbnailExporterBatch.generated.h"
+
+UENUM(BlueprintType)
+enum class EThumbnailExportStatus : uint8
+{
+	// The thumbnail could not be exported
+	Failed,
+	// There was no existing thumbnail texture, a new one was created
+	New,
+	// The existing thumbnail texture was different, and was overwritten
+	Changed,
+	// The existing thumbnail texture already had the same pixels and settings, so it was left untouched
+	Identical,
+	// Another asset in the batch rendered the same image, the asset uses that asset's texture
+	Deduplicated,
+	// The thumbnail was packed into an atlas page
+	Atlased,
+	// The export was cancelled before the asset was exported
+	Cancelled,
+	// The asset was left out because there was nothing to render, such as a blueprint without any visible mesh components
+	Skipped
+};
+
+USTRUCT(BlueprintType)
+struct FThumbnailExportResult
+{
+	GENERATED_USTRUCT_BODY()
+
+	// The asset the thumbnail was exported from
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		FAssetData Asset;
+
+	// Package path of the exported thumbnail texture. For deduplicated thumbnails, this is the shared texture
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		FString ThumbnailPath;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		bool bSuccess = false;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		EThumbnailExportStatus Status = EThumbnailExportStatus::Failed;
+
+	// Size of the uncompressed texture source, in bytes
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		int64 RawSourceBytes = 0;
+
+	// Size of the texture source as it is stored in the package, in bytes
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		int64 StoredSourceBytes = 0;
+
+	// Index of the atlas page the thumbnail was packed into, or INDEX_NONE if it wasn't atlased
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		int32 AtlasPage = INDEX_NONE;
+
+	// UV rect of the thumbnail inside its texture
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		FVector2D AtlasUVOffset = FVector2D::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		FVector2D AtlasUVSize = FVector2D::UnitVector;
+
+	// Number of frames in the thumbnail. Thumbnails with more than one frame are sprite sheets, laid out left to right then top to bottom
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		int32 NumFrames = 1;
+
+	// Number of columns of frames in the sprite sheet
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		int32 NumFrameColumns = 1;
+
+	// True if the rendered thumbnail came from the Derived Data Cache instead of being rendered
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		bool bFromCache = false;
+
+	// Triangles in the LODs the asset was rendered with, per frame. Zero for thumbnails from the Derived Data Cache
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		int64 NumTriangles = 0;
+
+	// Time spent exporting the thumbnail, per stage
+	FThumbnailExportStageTimings Timings;
+};
+
+USTRUCT(BlueprintType)
+struct FThumbnailExportBatchReport
+{
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		TArray<FThumbnailExportResult> Results;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		int32 NumExported = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		int32 NumFailed = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		int32 NumNew = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		int32 NumChanged = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		int32 NumIdentical = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		int32 NumDeduplicated = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		int32 NumAtlased = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		int32 NumCancelled = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		int32 NumSkipped = 0;
+
+	// Number of thumbnails that came from the Derived Data Cache instead of being rendered
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		int32 NumFromCache = 0;
+
+	// Package paths of the atlas pages written by the batch
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		TArray<FString> AtlasPagePaths;
+
+	// Package path of the manifest written by the batch. Empty if no manifest was written
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		FString ManifestPath;
+
+	// Total size of the uncompressed texture sources, in bytes
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		int64 RawSourceBytes = 0;
+
+	// Total size of the texture sources as they are stored in the packages, in bytes
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		int64 StoredSourceBytes = 0;
+
+	// Wall clock time the batch took, in seconds
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		double TotalSeconds = 0.0;
+
+	// Path of the JSON timing report written for the batch. The CSV report is written next to it. Empty if no report was written
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		FString TimingReportPath;
+
+	// Time spent in each stage, summed over the whole batch
+	FThumbnailExportStageTimings Timings;
+
+	int64 GetSourceBytesSaved() const { return RawSourceBytes - StoredSourceBytes; }
+};
+
+DECLARE_DELEGATE_OneParam(FOnThumbnailExported, const FThumbnailExportResult& /*Result*/);
+
+/**
+ * Exports the thumbnails of a list of assets.
+ * Thumbnails are rendered on the game thread while the previously rendered thumbnail is encoded on a worker thread,
+ * then written once the next thumbnail has been rendered.
+ */
+class THUMBNAILEXPORTER_API FThumbnailExporterBatch
+{
+public:
+	FThumbnailExporterBatch(const FThumbnailCreationConfig& InCreationConfig, const TArray<FAssetData>& InAssets, const FPreCreateThumbnail& InCreationDelegate = {}, const FOnThumbnailExported& InOnThumbnailExported = {});
+	~FThumbnailExporterBatch();
+
+	// Renders the next asset and writes the previously rendered one
+	// Returns false once every asset has been exported
+	bool ExportNext();
+
+	// Exports all of the remaining assets
+	void ExportAll();
+
+	// Writes the last rendered thumbnail and logs the report. Called by ExportNext after the last asset has been rendered
+	void Finish();
+
+	// Stops the export. The thumbnails that were already rendered are still written, the remaining assets are marked as cancelled
+	void Cancel();
+
+	bool IsFinished() const { return bFinished; }
+	int32 GetNumAssets() const { return Assets.Num(); }
+	int32 GetNumProcessed() const { return NextAssetIndex; }
+	const FThumbnailExportBatchReport& GetReport() const { return Report; }
+
+protected:
+	struct FPendingThumbnail;
+
+	// Renders the asset and starts encoding it on a worker thread. Returns nullptr if the thumbnail could not be rendered
+	TUniquePtr<FPendingThumbnail> RenderThumbnail(const FAssetData& Asset, FThumbnailExportResult& Result);
+
+	// Waits for the thumbnail to be encoded then writes it to its texture package
+	void WriteThumbnail(FPendingThumbnail& Pending);
+
+	// Packs the thumbnails collected for the atlas into pages and writes them
+	void WriteAtlas();
+
+	// Releases the thumbnails collected for the atlas
+	void EmptyAtlasImages();
+
+	// Deletes the atlas pages an earlier export of the same manifest wrote past the last page of this one
+	void DeleteStaleAtlasPages();
+
+	// Adds the exported thumbnails to the manifest and saves it
+	void WriteManifest();
+
+	// Writes the per-stage timings of the batch to Saved/ThumbnailExporter/Reports as JSON and CSV
+	void WriteTimingReport();
+
+	// Calls OnThumbnailExported for a result that won't change anymore
+	void BroadcastResult(int32 ResultIndex) const;
+
+	// Returns the package path of the manifest, or an empty string if there isn't anything to put in it
+	FString GetManifestPackagePath() const;
+
+	// Thumbnail waiting to be packed into an atlas page
+	struct FAtlasImage
+	{
+		int32 SizeX = 0;
+		int32 SizeY = 0;
+		TArray<FColor> Pixels;
+
+		// Results of the assets that use this image
+		TArray<int32> ResultIndices;
+
+		int32 Page = INDEX_NONE;
+		FIntPoint Position = FIntPoint::ZeroValue;
+	};
+
+	FThumbnailCreationConfig CreationConfig;
+	TArray<FAssetData> Assets;
+	FPreCreateThumbnail CreationDelegate;
+
+	// Called once the result of an asset is final. Atlased results are final once the atlas pages are written
+	FOnThumbnailExported OnThumbnailExported;
+
+	int32 NextAssetIndex = 0;
+	bool bFinished = false;
+	bool bCancelled = false;
+	double StartTime = 0.0;
+
+	TUniquePtr<FPendingThumbnail> PendingThumbnail;
+	FThumbnailExportBatchReport Report;
+
+	// Thumbnail hash -> path of the texture that was written for it. Used to deduplicate thumbnails
+	TMap<uint64, FString> UniqueThumbnails;
+
+	TArray<FAtlasImage> AtlasImages;
+
+	// Package hashes and dependencies the cache keys of the batch are built from
+	FThumbnailExporterCache::FPackageHashes PackageHashes;
+
+	// Thumbnail hash -> index in AtlasImages. Used to deduplicate atlased thumbnails
+	TMap<uint64, int32> UniqueAtlasImages;
+
+	// Source sizes of the atlas pages, these don't belong to any single result
+	int64 AtlasRawSourceBytes = 0;
+	int64 AtlasStoredSourceBytes = 0;
+};
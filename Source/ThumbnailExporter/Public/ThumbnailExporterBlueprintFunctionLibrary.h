@@ -9,6 +9,7 @@
 
 struct FThumbnailCreationPreset;
 struct FThumbnailCreationConfig;
+class UThumbnailExporterAsyncExport;
 
 DECLARE_DYNAMIC_DELEGATE_RetVal_TwoParams(FThumbnailCreationConfig, FPreCreateThumbnail, const struct FThumbnailCreationConfig&, CreationConfig, AActor*, ThumbnailActor);
 
@@ -25,6 +26,12 @@ class THUMBNAILEXPORTER_API UThumbnailExporterBlueprintFunctionLibrary : public
 	UFUNCTION(BlueprintCallable, Category = "Thumbnail Exporter", meta=(AutoCreateRefTerm="CreationDelegate"))
 		static bool ExportThumbnail(const FThumbnailCreationConfig& CreationConfig, const FAssetData& Asset, FString& ThumbnailPath, const FPreCreateThumbnail& CreationDelegate);
 	
+	// Starts exporting the thumbnails of the assets in the background and returns straight away.
+	// Bind OnThumbnailExported and OnCompleted on the returned handle to be told when thumbnails are written, and call Cancel on it to stop the export.
+	// Meant for scripts, Blueprint graphs can use the Export Thumbnails Async node instead
+	UFUNCTION(BlueprintCallable, Category = "Thumbnail Exporter", meta=(AutoCreateRefTerm="CreationDelegate"))
+		static UThumbnailExporterAsyncExport* StartThumbnailExport(const FThumbnailCreationConfig& CreationConfig, const TArray<FAssetData>& Assets, const FPreCreateThumbnail& CreationDelegate);
+
 	// Returns true if a thumbnail can be created for the asset
 	UFUNCTION(BlueprintPure, Category = "Thumbnail Exporter")
 		static bool CanCreateThumbnail(const FAssetData& Asset);
@@ -0,0 +1,39 @@
+// Copyright 2023 Big Cat Energising. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FAssetData;
+struct FThumbnailCreationConfig;
+
+/**
+ * Stores rendered thumbnails in the Derived Data Cache, so any machine sharing the cache (or the same machine on a later export)
+ * can skip loading and rendering the asset and only write the texture
+ */
+class THUMBNAILEXPORTER_API FThumbnailExporterCache
+{
+public:
+	// Saved hashes and hard dependencies of the packages seen so far, so a batch only asks the asset registry about each package once
+	struct FPackageHashes
+	{
+		struct FPackageInfo
+		{
+			// Unset if the package was never saved
+			TOptional<FString> SavedHash;
+			TArray<FName> HardDependencies;
+		};
+
+		TMap<FName, FPackageInfo> Packages;
+	};
+
+	// Builds the cache key from the saved hash of the asset's package, the saved hashes of everything it hard depends on,
+	// the creation config and the plugin version. Soft references aren't part of the key, they aren't loaded with the asset.
+	// Returns false if the thumbnail can't be cached, e.g. because the asset or one of its dependencies has unsaved changes
+	static bool GetCacheKey(const FThumbnailCreationConfig& CreationConfig, const FAssetData& Asset, FString& OutCacheKey, FPackageHashes& PackageHashes);
+
+	// Returns true and fills in the thumbnail if it is in the cache
+	static bool GetThumbnail(const FString& CacheKey, int32& OutSizeX, int32& OutSizeY, TArray<FColor>& OutPixels);
+
+	static void PutThumbnail(const FString& CacheKey, int32 SizeX, int32 SizeY, TArrayView<const FColor> Pixels);
+};
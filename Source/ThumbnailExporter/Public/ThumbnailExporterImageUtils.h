@@ -0,0 +1,23 @@
+// Copyright 2023 Big Cat Energising. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * CPU side image operations applied to the rendered thumbnail before it is written to a texture
+ */
+class THUMBNAILEXPORTER_API FThumbnailExporterImageUtils
+{
+public:
+	// Fills the color of fully transparent pixels with the color of the nearest non-transparent pixels (pull-push fill).
+	// Used so that mip filtering and block compression don't pull the background color into the edges of the thumbnail.
+	static void BleedColorIntoTransparentPixels(TArrayView<FColor> Pixels, int32 SizeX, int32 SizeY);
+
+	// Finds the smallest rect containing every pixel with an alpha above AlphaThreshold. Scans 4 pixels at a time using SIMD.
+	// Returns false if there are no such pixels
+	static bool FindOpaqueBounds(TArrayView<const FColor> Pixels, int32 SizeX, int32 SizeY, uint8 AlphaThreshold, FIntRect& OutBounds);
+
+	// Returns the pixels inside Rect. Rect must be inside the image
+	static TArray<FColor> CropImage(TArrayView<const FColor> Pixels, int32 SizeX, int32 SizeY, const FIntRect& Rect);
+};
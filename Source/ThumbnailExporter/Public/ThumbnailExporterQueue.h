@@ -0,0 +1,74 @@
+// Copyright 2023 Big Cat Energising. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TickableEditorObject.h"
+#include "ThumbnailExporterBatch.h"
+
+class SNotificationItem;
+
+DECLARE_DELEGATE_OneParam(FOnThumbnailExportJobFinished, const FThumbnailExportBatchReport& /*Report*/);
+
+/**
+ * Exports batches of thumbnails in the background. Each editor tick exports thumbnails until the time budget
+ * from the settings is used up, so the editor stays responsive during large exports.
+ * Shows a progress notification with the throughput and remaining time, which can pause or cancel the queue.
+ */
+class THUMBNAILEXPORTER_API FThumbnailExporterQueue : public FTickableEditorObject
+{
+public:
+	FThumbnailExporterQueue();
+	virtual ~FThumbnailExporterQueue();
+
+	// Adds an export job to the end of the queue. Returns the id of the job
+	int32 Submit(const FThumbnailCreationConfig& CreationConfig, const TArray<FAssetData>& Assets, const FPreCreateThumbnail& CreationDelegate = {}, const FOnThumbnailExported& OnThumbnailExported = {}, const FOnThumbnailExportJobFinished& OnFinished = {});
+
+	// Cancels the job. Thumbnails that were already rendered are still written. Returns false if the job isn't in the queue
+	bool Cancel(int32 JobId);
+	void CancelAll();
+
+	void SetPaused(bool bInPaused);
+	bool IsPaused() const { return bPaused; }
+
+	bool IsEmpty() const { return Jobs.Num() == 0; }
+
+	// Assets in the queue that haven't been exported yet
+	int32 GetNumRemainingAssets() const;
+
+	// FTickableEditorObject implementation
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return Jobs.Num() > 0; }
+	virtual TStatId GetStatId() const override;
+
+protected:
+	struct FJob
+	{
+		int32 Id = INDEX_NONE;
+		TUniquePtr<FThumbnailExporterBatch> Batch;
+		FOnThumbnailExportJobFinished OnFinished;
+	};
+
+	// Removes the finished job from the queue and lets the submitter know
+	void FinishJob(int32 JobIndex);
+
+	void UpdateNotification();
+	void CloseNotification();
+
+	TArray<FJob> Jobs;
+	int32 NextJobId = 0;
+	bool bPaused = false;
+
+	// Progress since the queue was last empty, used for the notification
+	int32 NumQueuedAssets = 0;
+	int32 NumExportedAssets = 0;
+	int32 NumFailedAssets = 0;
+	int32 NumSkippedAssets = 0;
+	int32 NumCancelledAssets = 0;
+	double ActiveSeconds = 0.0;
+
+	TSharedPtr<SNotificationItem> Notification;
+
+	// Only ever referenced weakly, by the notification buttons. Released with the queue
+	TSharedRef<bool> AliveToken = MakeShared<bool>(true);
+};
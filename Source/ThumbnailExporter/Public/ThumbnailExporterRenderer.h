@@ -7,11 +7,29 @@
 #include "ThumbnailExporterBlueprintFunctionLibrary.h"
 
 struct FThumbnailCreationConfig;
+struct FThumbnailFrameCopy;
 class FObjectThumbnail;
 
+// What went into rendering a thumbnail
+struct FThumbnailRenderStats
+{
+	// Triangles in the rendered LODs of the asset, per frame
+	int64 NumTriangles = 0;
+
+	// False if the thumbnail wasn't rendered, but filled with the background color because there is no renderer
+	bool bRendered = false;
+};
+
 class THUMBNAILEXPORTER_API FThumbnailExporterRenderer
 {
 public:
-	static FObjectThumbnail* GenerateThumbnail(FThumbnailCreationConfig& CreationConfig, UObject* InObject, const FPreCreateThumbnail& CreationDelegate = {});
-	static void RenderThumbnail(FThumbnailCreationConfig& CreationConfig, UObject* InObject, const uint32 InImageWidth, const uint32 InImageHeight, ThumbnailTools::EThumbnailTextureFlushMode::Type InFlushMode, FObjectThumbnail* OutThumbnail = NULL, const FPreCreateThumbnail& CreationDelegate = {});
+	static FObjectThumbnail* GenerateThumbnail(FThumbnailCreationConfig& CreationConfig, UObject* InObject, const FPreCreateThumbnail& CreationDelegate = {}, FThumbnailRenderStats* OutStats = nullptr);
+	// Test only: without a renderer (-nullrhi), fill thumbnails with the background color instead of failing, so the CPU side of the export can be benchmarked.
+	// These thumbnails must never be saved over real ones, only the benchmark sets it
+	static bool bFillThumbnailsWithoutRenderer;
+
+	// Fills in the frames the renderer skipped because they look the same as an earlier frame, in read back BGRA pixels
+	static void CopyFrames(TArray<uint8>& ImageData, int32 ImageWidth, const TArray<FThumbnailFrameCopy>& FrameCopies);
+
+	static void RenderThumbnail(FThumbnailCreationConfig& CreationConfig, UObject* InObject, const uint32 InImageWidth, const uint32 InImageHeight, ThumbnailTools::EThumbnailTextureFlushMode::Type InFlushMode, FObjectThumbnail* OutThumbnail = NULL, const FPreCreateThumbnail& CreationDelegate = {}, FThumbnailRenderStats* OutStats = nullptr);
 };
@@ -5,6 +5,26 @@
 #include "CoreMinimal.h"
 
 #include "ThumbnailHelpers.h"
+#include "ThumbnailExporterSettings.h"
+#include "UObject/ObjectKey.h"
+
+/**
+ * The parts of the creation config that change how a thumbnail scene is built. Scenes are pooled by it,
+ * everything else in the config is applied to whichever scene is used
+ */
+struct THUMBNAILEXPORTER_API FThumbnailExporterSceneKey
+{
+	FThumbnailExporterSceneKey() = default;
+	explicit FThumbnailExporterSceneKey(const FThumbnailCreationConfig& CreationConfig);
+
+	bool bHideBackgroundMeshes = true;
+	bool bMinimalScene = false;
+
+	bool operator==(const FThumbnailExporterSceneKey& Other) const
+	{
+		return bHideBackgroundMeshes == Other.bHideBackgroundMeshes && bMinimalScene == Other.bMinimalScene;
+	}
+};
 
 /**
  * Thumbnail preview scene with support for both blueprints and static meshes
@@ -12,17 +32,23 @@
 class THUMBNAILEXPORTER_API FThumbnailExporterScene : public FThumbnailPreviewScene
 {
 public:
-	FThumbnailExporterScene(bool bInHideBackgroundMeshes);
+	explicit FThumbnailExporterScene(const FThumbnailExporterSceneKey& InSceneKey);
 	virtual ~FThumbnailExporterScene() = default;
 
 	/** Allocates then adds an FSceneView to the ViewFamily. */
 	FSceneView* CreateView(FSceneViewFamily* ViewFamily, int32 X, int32 Y, uint32 SizeX, uint32 SizeY) const;
 
+	/** Streams in the textures of the scene for the view. Every frame of a thumbnail is framed the same, so once per thumbnail is enough */
+	void StreamTextures(const FSceneView& View) const;
+
 	/** Returns true if this component can be visualized */
 	static bool IsValidComponentForVisualization(UActorComponent* Component);
 
-	/** Sets the static mesh to use in the next CreateView() */
-	void SetBlueprint(class UBlueprint* Blueprint);
+	/** Returns true if any of the component templates of the actor class can be visualized. Doesn't spawn anything */
+	static bool HasVisualComponentTemplates(class UClass* InClass);
+
+	/** Sets the blueprint to use in the next CreateView() */
+	void SetBlueprint(class UBlueprint* Blueprint, EThumbnailBlueprintSpawnMode SpawnMode = EThumbnailBlueprintSpawnMode::FullSpawn);
 
 	/** Refreshes components for the specified blueprint */
 	void BlueprintChanged(class UBlueprint* Blueprint);
@@ -33,32 +59,106 @@ public:
 	/** Sets the skeletal mesh to use in the next CreateView() */
 	void SetSkeletalMesh(class USkeletalMesh* InSkeletalMesh);
 
-	/** Sets override materials for the static mesh  */
+	/** Plays an animation on the skeletal mesh set by SetSkeletalMesh(), or goes back to the reference pose when null.
+	 *  Returns false if the animation can't be played on the skeletal mesh */
+	bool SetSkeletalMeshAnimation(class UAnimSequence* Animation);
+
+	/** Poses the skeletal mesh at Time seconds into its animation, and sends the pose to the render thread so the next rendered view family uses it */
+	void SetSkeletalMeshAnimationTime(float Time);
+
+	/** Sets the material to render on PreviewMesh in the next CreateView(). If bInFacePreviewMesh is true, the mesh is always seen from the front */
+	void SetMaterial(class UMaterialInterface* Material, class UStaticMesh* PreviewMesh, bool bInFacePreviewMesh);
+
+	/** Picks the LOD of every mesh component of the preview actor according to the config's LOD policy, as seen from View.
+	 *  FrameHeight is the height of the view in pixels. Returns the number of triangles in the picked LODs */
+	int64 ApplyLODPolicy(const FThumbnailCreationConfig& CreationConfig, const FSceneView& View, float FrameHeight);
+
+	/** Sets how the camera is fit around the preview actor in the next CreateView() */
+	void SetFraming(EThumbnailFramingMode InFramingMode, float InFramingMargin);
+
+	/** Sets the angles the next CreateView() calls render from. Pitch overrides the thumbnail info's orbit pitch when set */
+	void SetTurntable(int32 InNumTurntableAngles, float InTurntableStartYaw, TOptional<float> InTurntablePitch);
+
+	/** Sets which of the turntable angles the next CreateView() renders from */
+	void SetTurntableAngle(int32 InTurntableAngle);
+
+	/** Sets override materials for the static or skeletal mesh, by material slot. Null entries keep the mesh's own material */
 	void SetOverrideMaterials(const TArray<class UMaterialInterface*>& OverrideMaterials);
 
-	bool GetBackgroundMeshesHidden() const { return bHideBackgroundMeshes; }
+	/** Replaces the directional lights of a minimal scene. Does nothing in other scenes */
+	void SetMinimalSceneLights(const TArray<FThumbnailSceneLight>& Lights, float SkyBrightness);
+
+	const FThumbnailExporterSceneKey& GetSceneKey() const { return SceneKey; }
 	TWeakObjectPtr<class AActor> GetPreviewActor() const { return PreviewActor; }
 
 protected:
 	// FThumbnailPreviewScene implementation
 	virtual void GetViewMatrixParameters(const float InFOVDegrees, FVector& OutOrigin, float& OutOrbitPitch, float& OutOrbitYaw, float& OutOrbitZoom) const override;
 
-	/** Sets the object (class or blueprint) used in the next CreateView() */
-	void SpawnPreviewActor(class UClass* Obj);
+	/** Sets the object (class or blueprint) used in the next CreateView(). With bVisualComponentsOnly, only the visual components of the class are created */
+	void SpawnPreviewActor(class UClass* Obj, bool bVisualComponentsOnly = false);
+
+	/** Spawns an empty actor holding copies of the class's visual component templates, or the class itself if they are attached to sockets that can only be resolved on a spawned actor */
+	class AActor* SpawnVisualComponents(class UClass* InClass, const struct FActorSpawnParameters& SpawnInfo);
 
 	/** Get the scene thumbnail info to use for the object currently being rendered */
-	virtual USceneThumbnailInfo* GetSceneThumbnailInfo(const float TargetDistance) const;
+	virtual USceneThumbnailInfo* GetSceneThumbnailInfo() const;
 
 	FBoxSphereBounds GetPreviewActorBounds() const;
 
+	/** Returns the corners of the oriented bounding boxes of the preview actor's visible components */
+	TArray<FVector> GetPreviewActorBoxCorners() const;
+
+	/** Returns the smallest orbit zoom that keeps every corner of the preview actor's bounding boxes on screen */
+	float GetBoundingBoxOrbitZoom(const UObject* FramedAsset, const FBoxSphereBounds& Bounds, const FVector& Origin, float HalfFOVRadians, float OrbitPitch, float OrbitYaw) const;
+
 	/** Clears out any stale actors in this scene if PreviewActor enters a stale state */
 	void ClearStaleActors();
 
-	bool bHideBackgroundMeshes;
+	FThumbnailExporterSceneKey SceneKey;
+
+	/** Directional lights of the minimal scene, and the settings they were last set up with */
+	TArray<class UDirectionalLightComponent*> MinimalSceneLights;
+	TArray<FThumbnailSceneLight> AppliedMinimalSceneLights;
+	float AppliedMinimalSceneSkyBrightness = -1.f;
 
 	int32 NumStartingActors;
 	TWeakObjectPtr<class AActor> PreviewActor;
 
+	/** The class PreviewActor was spawned for, and whether it only holds the class's visual components */
+	TWeakObjectPtr<class UClass> PreviewActorClass;
+	bool bPreviewActorVisualComponentsOnly = false;
+
 	/** The blueprint that is currently being rendered. NULL when not rendering. */
 	TWeakObjectPtr<class UBlueprint> CurrentBlueprint;
+	EThumbnailBlueprintSpawnMode BlueprintSpawnMode = EThumbnailBlueprintSpawnMode::FullSpawn;
+
+	EThumbnailFramingMode FramingMode;
+	float FramingMargin;
+
+	int32 NumTurntableAngles;
+	int32 TurntableAngle;
+	float TurntableStartYaw;
+	TOptional<float> TurntablePitch;
+
+	/** True while rendering a material on a plane, which has to be seen face on */
+	bool bFacePreviewMesh;
+
+	/** Returns the yaw the turntable angle is rendered from, relative to the thumbnail info's orbit yaw */
+	float GetTurntableYawOffset(int32 InTurntableAngle) const;
+
+	struct FFramingCacheEntry
+	{
+		FBoxSphereBounds Bounds;
+		float HalfFOVRadians;
+		float OrbitPitch;
+		float OrbitYaw;
+		float FramingMargin;
+		float OrbitZoom;
+	};
+
+	/** Bounding box framing of FramingCacheAsset per orbit yaw. Every thumbnail is rendered more than once (color and alpha, and once per turntable angle).
+	 *  Only the current asset is kept, so the cache never holds more than one entry per turntable angle however long the scene is pooled */
+	mutable TMap<float, FFramingCacheEntry> FramingCache;
+	mutable FObjectKey FramingCacheAsset;
 };
@@ -0,0 +1,47 @@
+// Copyright 2023 Big Cat Energising. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ThumbnailExporterServerCommandlet.generated.h"
+
+class FSocket;
+
+/**
+ * Keeps an editor running and exports thumbnails for requests received over a local TCP socket, so jobs don't pay for an editor
+ * startup and shader warmup each time.
+ *
+ * Run with: UnrealEditor-Cmd <Project> -run=ThumbnailExporterServer -AllowCommandletRendering [-Port=27815] [-MaxRequestBytes=16777216]
+ *
+ * Each request is a single line of JSON, answered with a single line of JSON:
+ *   {"Command": "Export", "Preset": "<preset menu name>", "Config": { <FThumbnailCreationConfig overrides> }, "Assets": ["/Game/Path/Asset.Asset"]}
+ *   {"Command": "Ping"}
+ *   {"Command": "Shutdown"}
+ */
+UCLASS()
+class UThumbnailExporterServerCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UThumbnailExporterServerCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+protected:
+	// Handles a JSON request and returns the JSON response
+	FString HandleRequest(const FString& Request);
+
+	// Exports the thumbnails described by the request
+	FString HandleExportRequest(const TSharedRef<class FJsonObject>& RequestObject);
+
+	// Keeps the engine ticking between requests so shader compilation and asset streaming carry on in the background
+	void TickIdle(float DeltaTime);
+
+	static bool SendResponse(FSocket* Socket, const FString& Response);
+
+	static FString MakeErrorResponse(const FString& Error);
+
+	bool bShutdownRequested = false;
+};
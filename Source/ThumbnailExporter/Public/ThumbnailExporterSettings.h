@@ -5,8 +5,119 @@
 #include "CoreMinimal.h"
 #include "Engine/DeveloperSettings.h"
 #include "Containers/Map.h"
+#include "ThumbnailExporterNaming.h"
 #include "ThumbnailExporterSettings.generated.h"
 
+UENUM(BlueprintType)
+enum class EThumbnailFramingMode : uint8
+{
+	// Fit the camera around the bounding sphere of the asset. Leaves a lot of empty space around long or flat assets
+	BoundingSphere,
+
+	// Fit the camera as close as possible around the bounding boxes of the asset's components, as seen from the thumbnail angle
+	BoundingBox
+};
+
+UENUM(BlueprintType)
+enum class EThumbnailCropMode : uint8
+{
+	// Keep the whole rendered thumbnail
+	None,
+
+	// Crop to the visible part of the asset, then scale it up to fill the thumbnail size
+	FitToSize,
+
+	// Crop to the visible part of the asset, and export the smaller (possibly non-square) texture.
+	// Cropped sizes usually aren't a power of two, so the texture won't have mips
+	Crop
+};
+
+UENUM(BlueprintType)
+enum class EThumbnailBlueprintSpawnMode : uint8
+{
+	// Only create the static and skeletal mesh components of the blueprint's component templates, placed where the templates put them.
+	// Construction scripts don't run, and there's no collision, physics or ticking. Not used when a creation delegate is bound
+	VisualComponentsOnly,
+
+	// Spawn the blueprint's actor class, running its construction scripts and registering all of its components
+	FullSpawn
+};
+
+UENUM(BlueprintType)
+enum class EThumbnailLODPolicy : uint8
+{
+	// Always render the most detailed LOD
+	Highest,
+
+	// Render the coarsest LOD the mesh would get if it covered as many pixels on a screen LODReferenceScreenHeight tall as it does in the thumbnail
+	Automatic,
+
+	// Render FixedLOD, or the mesh's last LOD if it has fewer
+	Fixed
+};
+
+UENUM(BlueprintType)
+enum class EThumbnailMaterialMode : uint8
+{
+	// Draw the material straight onto the thumbnail as a flat tile, without rendering a scene. By far the fastest, but unlit and always opaque
+	CanvasTile,
+
+	// Render the material on a lit preview mesh. The preview mesh is kept between material thumbnails, only its material is swapped
+	PreviewMesh
+};
+
+UENUM(BlueprintType)
+enum class EThumbnailMaterialPreviewMesh : uint8
+{
+	Sphere,
+
+	// Seen face on, whatever the thumbnail angle
+	Plane
+};
+
+USTRUCT(BlueprintType)
+struct FThumbnailSceneLight
+{
+	GENERATED_USTRUCT_BODY()
+
+	FThumbnailSceneLight() = default;
+	FThumbnailSceneLight(const FRotator& InRotation, float InIntensity)
+		: Rotation(InRotation)
+		, Intensity(InIntensity)
+	{
+
+	}
+
+	// Direction the directional light shines in
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail")
+		FRotator Rotation = FRotator::ZeroRotator;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail", meta = (ClampMin = 0, UIMin = 0, UIMax = 20))
+		float Intensity = 1.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail")
+		FLinearColor Color = FLinearColor::White;
+
+	bool operator==(const FThumbnailSceneLight& Other) const
+	{
+		return Rotation == Other.Rotation && Intensity == Other.Intensity && Color == Other.Color;
+	}
+};
+
+USTRUCT(BlueprintType)
+struct FThumbnailMaterialVariant
+{
+	GENERATED_USTRUCT_BODY()
+
+	// Name of the variant, only used to tell variants apart in the editor
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail")
+		FName Name;
+
+	// Override material for each material slot of the mesh, by slot index. Empty entries and slots past the end keep the mesh's own material
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail")
+		TArray<TSoftObjectPtr<class UMaterialInterface>> Materials;
+};
+
 USTRUCT(BlueprintType)
 struct FThumbnailCreationConfig
 {
@@ -51,10 +162,65 @@ struct FThumbnailCreationConfig
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Texture")
 		TEnumAsByte<TextureGroup> ThumbnailTextureGroup = TextureGroup::TEXTUREGROUP_UI;
 
+	// Compression used when building the thumbnail texture. Default picks DXT1/DXT5 depending on alpha, BC7 gives better quality for icons.
+	// Platforms that don't support BC formats (like mobile) automatically use the matching ASTC/ETC format
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Texture")
+		TEnumAsByte<TextureCompressionSettings> ThumbnailCompressionSettings = TextureCompressionSettings::TC_Default;
+
+	// How mips are generated for the thumbnail texture. Mips are only generated for power of two thumbnail sizes
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Texture")
+		TEnumAsByte<TextureMipGenSettings> ThumbnailMipGenSettings = TextureMipGenSettings::TMGS_FromTextureGroup;
+
+	// Keeps the opacity of the thumbnail consistent across mips, and fills fully transparent pixels with the nearest opaque color
+	// so the background color doesn't bleed into the edges of the lower mips
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Texture")
+		bool bAlphaAwareMipFiltering = true;
+
+	// If true, then the thumbnail texture's mips can be streamed in and out
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Texture")
+		bool bStreamable = false;
+
+	// Store the texture source PNG compressed instead of as raw BGRA8. Shrinks the size of the thumbnail packages on disk.
+	// The compression is done on a worker thread while the next thumbnail renders. Off by default so existing exports keep writing the same packages
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Texture")
+		bool bCompressTextureSource = false;
+
+	// Crops away the empty space around the asset after rendering. Only works with a transparent background
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Crop")
+		EThumbnailCropMode CropMode = EThumbnailCropMode::None;
+
+	// Pixels with an alpha at or below this value count as empty space when cropping
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Crop", meta = (EditCondition = "CropMode != EThumbnailCropMode::None", ClampMin = 0, UIMin = 0, ClampMax = 254, UIMax = 254))
+		int32 CropAlphaThreshold = 0;
+
+	// Empty space kept around the asset when cropping, in pixels of the rendered thumbnail
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Crop", meta = (EditCondition = "CropMode != EThumbnailCropMode::None", ClampMin = 0, UIMin = 0))
+		int32 CropPadding = 4;
+
 	// Hide the background meshes present in the asset thumbnail. Hides the checkerboard background
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Scene")
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Scene", meta = (EditCondition = "!bUseMinimalScene"))
 		bool bHideThumbnailBackgroundMeshes = true;
 
+	// Render in a scene that only contains the preview actor, MinimalSceneLights and the sky light. The background meshes of the asset
+	// thumbnail scene are removed from the scene instead of hidden, so they don't take part in shadow, depth or visibility passes either
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Scene")
+		bool bUseMinimalScene = false;
+
+	// Directional lights of the minimal scene. Defaults to the key and fill lights of the asset thumbnail scene
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Scene", meta = (EditCondition = "bUseMinimalScene"))
+		TArray<FThumbnailSceneLight> MinimalSceneLights = { FThumbnailSceneLight(FRotator(-40.f, -144.678f, 0.f), 5.f), FThumbnailSceneLight(FRotator(299.235f, 144.993f, 0.f), 1.f) };
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Scene", meta = (EditCondition = "bUseMinimalScene", ClampMin = 0, UIMin = 0, UIMax = 10))
+		float MinimalSceneSkyBrightness = 1.f;
+
+	// How the camera is fit around the asset
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Scene")
+		EThumbnailFramingMode FramingMode = EThumbnailFramingMode::BoundingSphere;
+
+	// Fraction of the thumbnail kept empty around the asset when framing to the bounding box
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Scene", meta = (EditCondition = "FramingMode == EThumbnailFramingMode::BoundingBox", ClampMin = 0, UIMin = 0, ClampMax = 0.9, UIMax = 0.5))
+		float FramingMargin = 0.05f;
+
 	// Enable post-processing (like bloom) in the thumbnail
 	// 
 	// If transparent backgrounds are not working, try toggling off post-processing
@@ -65,6 +231,107 @@ struct FThumbnailCreationConfig
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Scene", meta = (EditCondition = "bEnablePostProcessing"))
 		bool bEnableBloom = false;
 
+	// Number of yaw angles to render the asset from, evenly spaced around it. With more than one angle, the angles are rendered
+	// as frames of a sprite sheet, left to right then top to bottom, each ThumbnailSize in size. The scene is only set up once for all of them
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Turntable", meta = (ClampMin = 1, UIMin = 1, ClampMax = 64, UIMax = 16))
+		int32 NumTurntableAngles = 1;
+
+	// Yaw of the first angle, in degrees, relative to the asset's thumbnail angle
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Turntable", meta = (EditCondition = "NumTurntableAngles > 1"))
+		float TurntableStartYaw = 0.f;
+
+	// If true, then every angle uses TurntablePitch instead of the asset's thumbnail pitch. Isometric views usually want a fixed pitch
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Turntable", meta = (EditCondition = "NumTurntableAngles > 1"))
+		bool bOverrideTurntablePitch = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Turntable", meta = (EditCondition = "NumTurntableAngles > 1 && bOverrideTurntablePitch", ClampMin = -89, UIMin = -89, ClampMax = 89, UIMax = 89))
+		float TurntablePitch = -30.f;
+
+	// How exported blueprints are put in the thumbnail scene. Blueprints whose construction scripts change their meshes need a full spawn.
+	// Exports with a creation delegate always fully spawn, since the delegate expects the blueprint's own actor
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Blueprint")
+		EThumbnailBlueprintSpawnMode BlueprintSpawnMode = EThumbnailBlueprintSpawnMode::FullSpawn;
+
+	// If true, batch exports skip blueprints without a visible static or skeletal mesh component template (managers, volumes...) instead of rendering a blank thumbnail.
+	// Only applies to visual component spawns without a creation delegate, since construction scripts and delegates can add meshes this check doesn't see
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Blueprint", meta = (EditCondition = "BlueprintSpawnMode == EThumbnailBlueprintSpawnMode::VisualComponentsOnly"))
+		bool bSkipNonVisualBlueprints = true;
+
+	// Animation played on exported skeletal meshes. The thumbnail becomes a flipbook sprite sheet of NumFlipbookFrames poses sampled evenly over
+	// the animation, each with every turntable angle. Assets that aren't skeletal meshes of a compatible skeleton are rendered in their reference pose
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Animation")
+		TSoftObjectPtr<class UAnimSequence> FlipbookAnimation;
+
+	// Number of poses sampled from the flipbook animation. The first frame is the start of the animation, the last is one step before its end so the flipbook loops
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Animation", meta = (EditCondition = "!FlipbookAnimation.IsNull()", ClampMin = 1, UIMin = 1, ClampMax = 256, UIMax = 64))
+		int32 NumFlipbookFrames = 16;
+
+	// Which LOD of static and skeletal meshes is rendered, including the mesh components of blueprints
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|LOD")
+		EThumbnailLODPolicy LODPolicy = EThumbnailLODPolicy::Highest;
+
+	// Screen height, in pixels, the LOD screen sizes of the meshes are meant for. Acts as the error threshold of the automatic LOD policy:
+	// the higher it is, the more detailed the LODs picked for the thumbnail
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|LOD", meta = (EditCondition = "LODPolicy == EThumbnailLODPolicy::Automatic", ClampMin = 1, UIMin = 128, UIMax = 4320))
+		float LODReferenceScreenHeight = 1080.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|LOD", meta = (EditCondition = "LODPolicy == EThumbnailLODPolicy::Fixed", ClampMin = 0, UIMin = 0, UIMax = 7))
+		int32 FixedLOD = 0;
+
+	// How materials are exported
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Material")
+		EThumbnailMaterialMode MaterialMode = EThumbnailMaterialMode::PreviewMesh;
+
+	// Mesh materials are rendered on in PreviewMesh mode
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Material", meta = (EditCondition = "MaterialMode == EThumbnailMaterialMode::PreviewMesh"))
+		EThumbnailMaterialPreviewMesh MaterialPreviewMesh = EThumbnailMaterialPreviewMesh::Sphere;
+
+	// Material override sets to render static and skeletal meshes with. Each variant is a block of frames in the thumbnail's sprite sheet,
+	// holding every flipbook pose and turntable angle. The preview actor and its framing are shared by every variant, only the materials are swapped
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Material Variants", meta = (TitleProperty = "Name"))
+		TArray<FThumbnailMaterialVariant> MaterialVariants;
+
+	// If true, then thumbnails that are identical to the existing thumbnail texture (same pixels and texture settings) are not saved again.
+	// Keeps unchanged thumbnails from showing up as modified in source control
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = Thumbnail)
+		bool bSkipUnchangedThumbnails = true;
+
+	// If true, then assets in the same batch that render to exactly the same image share a single texture instead of each getting their own.
+	// The manifest maps every exported asset to the texture its thumbnail ended up in
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Batch")
+		bool bDeduplicateThumbnails = false;
+
+	// If true, then the thumbnails of a batch are packed into shared atlas textures instead of getting their own texture.
+	// The manifest maps every exported asset to its atlas page and UV rect. Each atlased export replaces the manifest's atlas pages
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Batch")
+		bool bPackIntoAtlas = false;
+
+	// Width and height of the atlas pages, in pixels
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Batch", meta = (EditCondition = "bPackIntoAtlas", ClampMin = 256, UIMin = 256, ClampMax = 8192, UIMax = 8192))
+		int32 AtlasSize = 2048;
+
+	// Empty space left between thumbnails in the atlas, in pixels. Keeps neighbouring thumbnails from bleeding into each other in the lower mips
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Batch", meta = (EditCondition = "bPackIntoAtlas", ClampMin = 0, UIMin = 0))
+		int32 AtlasPadding = 4;
+
+	// Folder the manifest is saved to. If empty, the manifest is saved next to the first exported thumbnail
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Batch", meta = (ContentDir))
+		FDirectoryPath ManifestPath;
+
+	// Asset name of the manifest. Exports to an existing manifest add to it
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Batch")
+		FString ManifestName = "ThumbnailManifest";
+
+	// If true, then rendered thumbnails are stored in the Derived Data Cache and reused by any machine sharing the cache, as long as the asset,
+	// its dependencies and the config haven't changed. Assets with unsaved changes, and exports with a creation delegate, are always rendered
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Batch")
+		bool bUseDerivedDataCache = true;
+
+	// If true, then every batch writes how long each export stage took to Saved/ThumbnailExporter/Reports, as JSON and CSV.
+	// Off by default, every export is a batch, so the reports pile up quickly
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Batch")
+		bool bWriteTimingReport = false;
+
 	// If true, then when the thumbnail texture is created, a notification will pop up with a link to the texture
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = Thumbnail)
 		bool bCreateThumbnailNotification = true;
@@ -86,6 +353,59 @@ struct FThumbnailCreationConfig
 	{
 		return ThumbnailCaptureSource == ESceneCaptureSource::SCS_SceneColorHDR;
 	}
+
+	// The part of the filename settings the runtime needs to find the thumbnails, see UThumbnailExporterRuntimeSettings
+	FThumbnailNamingRules GetNamingRules() const
+	{
+		FThumbnailNamingRules NamingRules;
+		NamingRules.bOverrideThumbnailPath = bOverrideThumbnailPath;
+		NamingRules.ThumbnailOverridePath = ThumbnailOverridePath;
+		NamingRules.ThumbnailPrefix = ThumbnailPrefix;
+		NamingRules.ThumbnailSuffix = ThumbnailSuffix;
+		return NamingRules;
+	}
+
+	// Returns true if batch exports with this config write a manifest
+	bool WritesManifest() const
+	{
+		return bDeduplicateThumbnails || bPackIntoAtlas;
+	}
+
+	// Number of frames rendered into the thumbnail. Thumbnails with more than one frame are sprite sheets.
+	// Frames are ordered by material variant, then by flipbook pose, then by turntable angle
+	int32 GetNumFrames() const
+	{
+		return GetNumMaterialVariants() * GetNumFlipbookFrames() * GetNumTurntableAngles();
+	}
+
+	int32 GetNumMaterialVariants() const
+	{
+		return FMath::Max(MaterialVariants.Num(), 1);
+	}
+
+	int32 GetNumTurntableAngles() const
+	{
+		return FMath::Max(NumTurntableAngles, 1);
+	}
+
+	int32 GetNumFlipbookFrames() const
+	{
+		return FlipbookAnimation.IsNull() ? 1 : FMath::Max(NumFlipbookFrames, 1);
+	}
+
+	// Number of columns and rows of frames in the thumbnail
+	FIntPoint GetFrameGridSize() const
+	{
+		const int32 NumFrames = GetNumFrames();
+		const int32 NumColumns = FMath::CeilToInt(FMath::Sqrt((float)NumFrames));
+		return FIntPoint(NumColumns, FMath::DivideAndRoundUp(NumFrames, NumColumns));
+	}
+
+	// Size of the whole rendered thumbnail, including every frame. Exports fail if it is larger than the RHI's maximum texture size
+	FIntPoint GetRenderSize() const
+	{
+		return GetFrameGridSize() * ThumbnailSize;
+	}
 };
 
 USTRUCT(BlueprintType)
@@ -115,5 +435,19 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail Exporter Settings", meta = (TitleProperty = "{MenuItemName}", ShowOnlyInnerProperties))
 		TArray<FThumbnailCreationPreset> ThumbnailCreationPresets = { FThumbnailCreationPreset() };
 
+	// How long exports started from the content browser may spend exporting thumbnails each editor frame, in milliseconds.
+	// At least one thumbnail is exported per frame. Higher values export faster but make the editor less responsive
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Export Queue", meta = (ClampMin = 1, UIMin = 1, UIMax = 500))
+		float ExportQueueTimeBudgetMs = 50.f;
+
+	// If true, then saving or reimporting an asset that has an exported thumbnail re-exports the thumbnail in the background,
+	// using the preset it was exported with
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Auto Re-export")
+		bool bReexportThumbnailsOnSave = false;
+
+	// How long to wait after the last save before re-exporting, in seconds. Saves made within this window are re-exported together
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Auto Re-export", meta = (EditCondition = "bReexportThumbnailsOnSave", ClampMin = 0, UIMin = 0, UIMax = 30))
+		float ReexportDebounceSeconds = 2.f;
+
 	static UThumbnailExporterSettings* Get() { return GetMutableDefault<UThumbnailExporterSettings>(); }
 };
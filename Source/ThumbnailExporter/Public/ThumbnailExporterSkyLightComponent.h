@@ -0,0 +1,32 @@
+// Copyright 2023 Big Cat Energising. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SkyLightComponent.h"
+#include "ThumbnailExporterSkyLightComponent.generated.h"
+
+/**
+ * Sky light used by the thumbnail scenes. Thumbnail scenes are never ticked, so a regular sky light only gets captured
+ * whenever something else happens to update the sky captures of the world, which gives inconsistent ambient lighting.
+ * This one is captured once when the scene is created, and shares its capture with every other thumbnail scene sky light
+ * that has the same capture settings
+ */
+UCLASS(Transient, NotBlueprintable)
+class THUMBNAILEXPORTER_API UThumbnailExporterSkyLightComponent : public USkyLightComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Copies the capture of another sky light with the same capture settings, or captures the sky if there isn't one.
+	// Does nothing if the sky light already has a capture. Re-registering the sky light drops its capture
+	void CaptureOnce();
+
+protected:
+	virtual void OnUnregister() override;
+
+	// Whether the other sky light's capture can be used for this one. Intensity and light color are applied when rendering, so they don't matter
+	bool HasSameCaptureSettings(const UThumbnailExporterSkyLightComponent& Other) const;
+
+	bool bHasCapture = false;
+};
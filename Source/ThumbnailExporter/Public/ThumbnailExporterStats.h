@@ -0,0 +1,103 @@
+// Copyright 2023 Big Cat Energising. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+DECLARE_STATS_GROUP(TEXT("Thumbnail Exporter"), STATGROUP_ThumbnailExporter, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Derived Data Cache"), STAT_ThumbnailExporter_DerivedDataCache, STATGROUP_ThumbnailExporter, THUMBNAILEXPORTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Asset Load"), STAT_ThumbnailExporter_AssetLoad, STATGROUP_ThumbnailExporter, THUMBNAILEXPORTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Shader Compile"), STAT_ThumbnailExporter_ShaderCompile, STATGROUP_ThumbnailExporter, THUMBNAILEXPORTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Texture Streaming"), STAT_ThumbnailExporter_TextureStreaming, STATGROUP_ThumbnailExporter, THUMBNAILEXPORTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Scene Setup"), STAT_ThumbnailExporter_SceneSetup, STATGROUP_ThumbnailExporter, THUMBNAILEXPORTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Render Color"), STAT_ThumbnailExporter_RenderColor, STATGROUP_ThumbnailExporter, THUMBNAILEXPORTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Render Alpha"), STAT_ThumbnailExporter_RenderAlpha, STATGROUP_ThumbnailExporter, THUMBNAILEXPORTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Flush Rendering"), STAT_ThumbnailExporter_FlushRendering, STATGROUP_ThumbnailExporter, THUMBNAILEXPORTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Readback"), STAT_ThumbnailExporter_Readback, STATGROUP_ThumbnailExporter, THUMBNAILEXPORTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Alpha Merge"), STAT_ThumbnailExporter_AlphaMerge, STATGROUP_ThumbnailExporter, THUMBNAILEXPORTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Image Processing"), STAT_ThumbnailExporter_ImageProcessing, STATGROUP_ThumbnailExporter, THUMBNAILEXPORTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Encode"), STAT_ThumbnailExporter_Encode, STATGROUP_ThumbnailExporter, THUMBNAILEXPORTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Encode Wait"), STAT_ThumbnailExporter_EncodeWait, STATGROUP_ThumbnailExporter, THUMBNAILEXPORTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Texture Build"), STAT_ThumbnailExporter_TextureBuild, STATGROUP_ThumbnailExporter, THUMBNAILEXPORTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Save Package"), STAT_ThumbnailExporter_SavePackage, STATGROUP_ThumbnailExporter, THUMBNAILEXPORTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Atlas Packing"), STAT_ThumbnailExporter_AtlasPacking, STATGROUP_ThumbnailExporter, THUMBNAILEXPORTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Manifest"), STAT_ThumbnailExporter_Manifest, STATGROUP_ThumbnailExporter, THUMBNAILEXPORTER_API);
+
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Render Target Memory"), STAT_ThumbnailExporter_RenderTargetMemory, STATGROUP_ThumbnailExporter, THUMBNAILEXPORTER_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Pending Thumbnail Memory"), STAT_ThumbnailExporter_PendingThumbnailMemory, STATGROUP_ThumbnailExporter, THUMBNAILEXPORTER_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Atlas Image Memory"), STAT_ThumbnailExporter_AtlasImageMemory, STATGROUP_ThumbnailExporter, THUMBNAILEXPORTER_API);
+
+// Unreal Insights channel for the export stages. Enable with -trace=cpu,ThumbnailExporter
+UE_TRACE_CHANNEL_EXTERN(ThumbnailExporterChannel, THUMBNAILEXPORTER_API);
+
+enum class EThumbnailExportStage : uint8
+{
+	DerivedDataCache,
+	AssetLoad,
+	ShaderCompile,
+	TextureStreaming,
+	SceneSetup,
+	RenderColor,
+	RenderAlpha,
+	FlushRendering,
+	Readback,
+	AlphaMerge,
+	ImageProcessing,
+	Encode,
+	EncodeWait,
+	TextureBuild,
+	SavePackage,
+	AtlasPacking,
+	Manifest,
+
+	Num
+};
+
+/**
+ * Time spent in each export stage, in seconds
+ */
+struct THUMBNAILEXPORTER_API FThumbnailExportStageTimings
+{
+	double Seconds[(int32)EThumbnailExportStage::Num] = {};
+
+	double& operator[](EThumbnailExportStage Stage) { return Seconds[(int32)Stage]; }
+	double operator[](EThumbnailExportStage Stage) const { return Seconds[(int32)Stage]; }
+
+	FThumbnailExportStageTimings& operator+=(const FThumbnailExportStageTimings& Other);
+
+	double GetTotalSeconds() const;
+
+	static const TCHAR* GetStageName(EThumbnailExportStage Stage);
+};
+
+/**
+ * Adds the time spent in its scope to a stage of the active timings. Nested scopes are exclusive,
+ * time spent in an inner stage doesn't count towards the outer stage. Only times the game thread
+ */
+class THUMBNAILEXPORTER_API FThumbnailExportStageScope
+{
+public:
+	explicit FThumbnailExportStageScope(EThumbnailExportStage InStage);
+	~FThumbnailExportStageScope();
+
+	// Timings that new stage scopes add to. Set by the batch around the work done for each asset, null when nothing is being timed
+	static FThumbnailExportStageTimings* ActiveTimings;
+
+private:
+	EThumbnailExportStage Stage;
+	FThumbnailExportStageTimings* Timings;
+	FThumbnailExportStageScope* ParentScope;
+	double StartTime;
+
+	static FThumbnailExportStageScope* CurrentScope;
+};
+
+// Times a stage of the export in the stats system, in Insights and in the batch report
+#define SCOPE_THUMBNAIL_EXPORT_STAGE(Stage) \
+	SCOPE_CYCLE_COUNTER(STAT_ThumbnailExporter_##Stage); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(ThumbnailExporter_##Stage, ThumbnailExporterChannel); \
+	FThumbnailExportStageScope PREPROCESSOR_JOIN(ThumbnailExportStageScope, __LINE__)(EThumbnailExportStage::Stage)
@@ -0,0 +1,77 @@
+// Copyright 2023 Big Cat Energising. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TickableEditorObject.h"
+
+class UPackage;
+class FObjectPostSaveContext;
+struct FAssetData;
+
+/**
+ * Re-exports thumbnails when the assets they were exported from, or anything those assets depend on, are saved or reimported.
+ * Changes are collected until none have been made for the debounce time in the settings, then the affected thumbnails
+ * are re-exported through the export queue, one job per preset.
+ */
+class THUMBNAILEXPORTER_API FThumbnailExporterWatcher : public FTickableEditorObject
+{
+public:
+	FThumbnailExporterWatcher();
+	virtual ~FThumbnailExporterWatcher();
+
+	// FTickableEditorObject implementation
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return ChangedPackages.Num() > 0; }
+	virtual TStatId GetStatId() const override;
+
+protected:
+	void RegisterReimportDelegate();
+
+	void OnPackageSaved(const FString& PackageFilename, UPackage* Package, FObjectPostSaveContext ObjectSaveContext);
+	void OnAssetReimported(UObject* Asset);
+	void OnAssetRegistryChanged(const FAssetData& Asset);
+	void OnAssetRenamed(const FAssetData& Asset, const FString& OldObjectPath);
+	void OnSettingsChanged(UObject* Settings, struct FPropertyChangedEvent& PropertyChangedEvent);
+
+	void AddChangedPackage(FName PackageName);
+
+	// Queues re-exports for the thumbnails of everything in ChangedPackages and everything that depends on them
+	void ReexportChangedPackages();
+
+	// Walks the reverse dependency graph from the changed packages. OutAffectedPackages includes the changed packages themselves
+	void CollectAffectedPackages(const TSet<FName>& InChangedPackages, TSet<FName>& OutAffectedPackages);
+
+	// Returns the packages that directly and hard reference the package
+	const TArray<FName>& GetReferencers(FName PackageName);
+
+	// Removes the cached referencers that the changed packages may have added or removed themselves from
+	void InvalidateReferencers(const TSet<FName>& InChangedPackages);
+
+	// Returns the indices of the presets the asset has an exported thumbnail for
+	const TArray<int32>& FindExportedPresets(const FAssetData& Asset);
+
+	// Removes the reverse index entries of the assets in the package, and of the assets whose thumbnail is the package
+	void InvalidateReverseIndex(FName PackageName);
+
+	// Changed packages waiting for the debounce time to pass
+	TSet<FName> ChangedPackages;
+	double LastChangeTime = 0.0;
+
+	// Asset -> indices of the presets that the asset has an exported thumbnail for. Built as assets are changed.
+	// Entries are invalidated when the asset's package or one of its thumbnail packages is added, removed or renamed,
+	// and the whole index is cleared when the presets change
+	TMap<FSoftObjectPath, TArray<int32>> ReverseIndex;
+
+	// Source or thumbnail package -> assets in ReverseIndex whose entry depends on it
+	TMultiMap<FName, FSoftObjectPath> ReverseIndexPackages;
+
+	// Package -> packages that directly reference it. Entries are invalidated when the packages referencing them are changed, added or removed,
+	// so walks only query the asset registry for the parts of the graph that changed
+	TMap<FName, TArray<FName>> ReferencersCache;
+
+	// Referencer -> packages in ReferencersCache whose referencers include it
+	TMultiMap<FName, FName> ReferencersCacheEntries;
+
+	FDelegateHandle PostEngineInitHandle;
+};
@@ -12,7 +12,8 @@ public class ThumbnailExporter : ModuleRules
 			new string[]
 			{
 				"Core",
-                "DeveloperSettings"
+                "DeveloperSettings",
+				"ThumbnailExporterRuntime"
             }
 		);
 		
@@ -25,7 +26,16 @@ public class ThumbnailExporter : ModuleRules
 				"SlateCore",
 				"UnrealEd",
 				"RHI",
-				"RenderCore"
+				"RenderCore",
+				"ImageWrapper",
+				"Json",
+				"JsonUtilities",
+				"Sockets",
+				"Networking",
+				"DerivedDataCache",
+				"Projects",
+				"MeshDescription",
+				"StaticMeshDescription"
 			}
 		);
 
@@ -0,0 +1,36 @@
+// Copyright 2023 Big Cat Energising. All Rights Reserved.
+
+
+#include "ThumbnailExporterNaming.h"
+
+#include "Misc/Paths.h"
+
+FString FThumbnailExporterNaming::GetThumbnailPackageName(const FThumbnailNamingRules& Rules, const FString& AssetObjectPath, const TOptional<FString>& OverrideFilename)
+{
+	FString FullPath;
+	if (OverrideFilename.IsSet())
+	{
+		FullPath = OverrideFilename.GetValue();
+	}
+	else
+	{
+		FullPath = Rules.ThumbnailPrefix + FPaths::GetBaseFilename(AssetObjectPath) + Rules.ThumbnailSuffix;
+	}
+
+	if (Rules.bOverrideThumbnailPath)
+	{
+		FullPath = Rules.ThumbnailOverridePath.Path / FullPath;
+	}
+	else
+	{
+		FullPath = FPaths::GetPath(AssetObjectPath) / FullPath;
+	}
+
+	return FullPath;
+}
+
+FSoftObjectPath FThumbnailExporterNaming::GetThumbnailTexturePath(const FThumbnailNamingRules& Rules, const FSoftObjectPath& Asset)
+{
+	const FString PackageName = GetThumbnailPackageName(Rules, Asset.GetAssetPathString());
+	return FSoftObjectPath(PackageName + TEXT(".") + FPaths::GetBaseFilename(PackageName));
+}
@@ -0,0 +1,8 @@
+// Copyright 2023 Big Cat Energising. All Rights Reserved.
+
+
+#include "ThumbnailExporterRuntime.h"
+
+DEFINE_LOG_CATEGORY(LogThumbnailExporterRuntime);
+
+IMPLEMENT_MODULE(FThumbnailExporterRuntimeModule, ThumbnailExporterRuntime)
@@ -0,0 +1,241 @@
+// Copyright 2023 Big Cat Energising. All Rights Reserved.
+
+
+#include "ThumbnailExporterSubsystem.h"
+
+#include "ThumbnailExporterRuntime.h"
+#include "ThumbnailExporterRuntimeSettings.h"
+#include "Engine/Texture2D.h"
+
+void UThumbnailExporterSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	const UThumbnailExporterRuntimeSettings* Settings = UThumbnailExporterRuntimeSettings::Get();
+	NamingRules = Settings->NamingRules;
+	SetTextureMemoryBudget(Settings->TextureMemoryBudgetMB);
+
+	// Only holds paths and UV rects, small enough to load up front so lookups never have to wait for it
+	Manifest = Settings->Manifest.LoadSynchronous();
+}
+
+void UThumbnailExporterSubsystem::Deinitialize()
+{
+	ClearCache();
+
+	// Nothing is left to answer the requests still loading
+	for (TPair<FSoftObjectPath, FCachedTexture>& CachedTexture : CachedTextures)
+	{
+		if (CachedTexture.Value.Handle.IsValid())
+		{
+			CachedTexture.Value.Handle->CancelHandle();
+		}
+	}
+	CachedTextures.Empty();
+	Manifest = nullptr;
+
+	Super::Deinitialize();
+}
+
+void UThumbnailExporterSubsystem::RequestThumbnail(const FSoftObjectPath& Asset, FOnThumbnailLoaded OnLoaded)
+{
+	const FThumbnailManifestEntry Entry = ResolveThumbnail(Asset);
+	const FSoftObjectPath TexturePath = Entry.Texture.ToSoftObjectPath();
+	if (TexturePath.IsNull())
+	{
+		OnLoaded.ExecuteIfBound(FThumbnailLoadResult());
+		return;
+	}
+
+	if (FCachedTexture* CachedTexture = CachedTextures.Find(TexturePath))
+	{
+		Stats.NumHits++;
+		CachedTexture->LastUsed = ++UseCounter;
+
+		if (!CachedTexture->bLoaded)
+		{
+			CachedTexture->PendingRequests.Add({ Entry, MoveTemp(OnLoaded) });
+			return;
+		}
+
+		OnLoaded.ExecuteIfBound(MakeLoadResult(Entry, CachedTexture->Texture.Get()));
+		return;
+	}
+
+	Stats.NumMisses++;
+
+	// Added before the load starts, the load completes straight away if the texture is already in memory
+	FCachedTexture& NewCachedTexture = CachedTextures.Add(TexturePath);
+	NewCachedTexture.LastUsed = ++UseCounter;
+	NewCachedTexture.PendingRequests.Add({ Entry, MoveTemp(OnLoaded) });
+
+	TSharedPtr<FStreamableHandle> Handle = StreamableManager.RequestAsyncLoad(TexturePath, FStreamableDelegate::CreateUObject(this, &UThumbnailExporterSubsystem::OnTextureLoaded, TexturePath));
+	if (FCachedTexture* CachedTexture = CachedTextures.Find(TexturePath))
+	{
+		CachedTexture->Handle = Handle;
+	}
+	else if (Handle.IsValid())
+	{
+		// The load failed straight away
+		Handle->ReleaseHandle();
+	}
+}
+
+void UThumbnailExporterSubsystem::K2_RequestThumbnail(TSoftObjectPtr<UObject> Asset, FOnThumbnailLoadedDynamic OnLoaded)
+{
+	RequestThumbnail(Asset.ToSoftObjectPath(), FOnThumbnailLoaded::CreateLambda([OnLoaded](const FThumbnailLoadResult& Result)
+	{
+		OnLoaded.ExecuteIfBound(Result);
+	}));
+}
+
+bool UThumbnailExporterSubsystem::FindThumbnail(TSoftObjectPtr<UObject> Asset, FThumbnailLoadResult& OutResult)
+{
+	const FThumbnailManifestEntry Entry = ResolveThumbnail(Asset.ToSoftObjectPath());
+
+	FCachedTexture* CachedTexture = CachedTextures.Find(Entry.Texture.ToSoftObjectPath());
+	if (CachedTexture == nullptr || !CachedTexture->bLoaded)
+	{
+		return false;
+	}
+
+	CachedTexture->LastUsed = ++UseCounter;
+	OutResult = MakeLoadResult(Entry, CachedTexture->Texture.Get());
+	return OutResult.bSuccess;
+}
+
+FThumbnailManifestEntry UThumbnailExporterSubsystem::ResolveThumbnail(const FSoftObjectPath& Asset) const
+{
+	if (Asset.IsNull())
+	{
+		return FThumbnailManifestEntry();
+	}
+
+	if (Manifest)
+	{
+		if (const FThumbnailManifestEntry* ManifestEntry = Manifest->FindThumbnail(Asset))
+		{
+			return *ManifestEntry;
+		}
+	}
+
+	FThumbnailManifestEntry Entry;
+	Entry.Texture = TSoftObjectPtr<UTexture2D>(FThumbnailExporterNaming::GetThumbnailTexturePath(NamingRules, Asset));
+	return Entry;
+}
+
+void UThumbnailExporterSubsystem::SetTextureMemoryBudget(float BudgetMB)
+{
+	Stats.BudgetBytes = (int64)(FMath::Max(BudgetMB, 0.f) * 1024.0 * 1024.0);
+	EvictToBudget(FSoftObjectPath());
+}
+
+FThumbnailCacheStats UThumbnailExporterSubsystem::GetCacheStats() const
+{
+	FThumbnailCacheStats CacheStats = Stats;
+	CacheStats.NumCachedTextures = 0;
+	for (const TPair<FSoftObjectPath, FCachedTexture>& CachedTexture : CachedTextures)
+	{
+		CacheStats.NumCachedTextures += CachedTexture.Value.bLoaded ? 1 : 0;
+	}
+	return CacheStats;
+}
+
+void UThumbnailExporterSubsystem::ClearCache()
+{
+	for (auto It = CachedTextures.CreateIterator(); It; ++It)
+	{
+		if (It.Value().bLoaded)
+		{
+			if (It.Value().Handle.IsValid())
+			{
+				It.Value().Handle->ReleaseHandle();
+			}
+			It.RemoveCurrent();
+		}
+	}
+	Stats.CachedBytes = 0;
+}
+
+void UThumbnailExporterSubsystem::OnTextureLoaded(FSoftObjectPath TexturePath)
+{
+	FCachedTexture* CachedTexture = CachedTextures.Find(TexturePath);
+	if (CachedTexture == nullptr)
+	{
+		return;
+	}
+
+	// The callbacks can request more thumbnails, so they run once the cache is done changing
+	TArray<FPendingRequest> PendingRequests = MoveTemp(CachedTexture->PendingRequests);
+
+	UTexture2D* Texture = Cast<UTexture2D>(TexturePath.ResolveObject());
+	if (Texture == nullptr)
+	{
+		UE_LOG(LogThumbnailExporterRuntime, Warning, TEXT("Failed to load thumbnail texture %s"), *TexturePath.ToString());
+		if (CachedTexture->Handle.IsValid())
+		{
+			CachedTexture->Handle->ReleaseHandle();
+		}
+		CachedTextures.Remove(TexturePath);
+	}
+	else
+	{
+		CachedTexture->Texture = Texture;
+		CachedTexture->bLoaded = true;
+		CachedTexture->Bytes = Texture->CalcTextureMemorySizeEnum(TMC_AllMips);
+		Stats.CachedBytes += CachedTexture->Bytes;
+
+		EvictToBudget(TexturePath);
+	}
+
+	for (FPendingRequest& PendingRequest : PendingRequests)
+	{
+		PendingRequest.OnLoaded.ExecuteIfBound(MakeLoadResult(PendingRequest.Entry, Texture));
+	}
+}
+
+void UThumbnailExporterSubsystem::EvictToBudget(const FSoftObjectPath& KeepTexturePath)
+{
+	while (Stats.CachedBytes > Stats.BudgetBytes)
+	{
+		FSoftObjectPath LeastRecentlyUsed;
+		uint64 LeastRecentUse = MAX_uint64;
+		for (const TPair<FSoftObjectPath, FCachedTexture>& CachedTexture : CachedTextures)
+		{
+			if (CachedTexture.Value.bLoaded && CachedTexture.Value.LastUsed < LeastRecentUse && CachedTexture.Key != KeepTexturePath)
+			{
+				LeastRecentlyUsed = CachedTexture.Key;
+				LeastRecentUse = CachedTexture.Value.LastUsed;
+			}
+		}
+
+		if (LeastRecentlyUsed.IsNull())
+		{
+			// Only the kept texture is left, it stays even if it's over the budget on its own
+			break;
+		}
+
+		FCachedTexture& Evicted = CachedTextures[LeastRecentlyUsed];
+		if (Evicted.Handle.IsValid())
+		{
+			Evicted.Handle->ReleaseHandle();
+		}
+		Stats.CachedBytes -= Evicted.Bytes;
+		Stats.NumEvictions++;
+		CachedTextures.Remove(LeastRecentlyUsed);
+
+		UE_LOG(LogThumbnailExporterRuntime, Verbose, TEXT("Evicted thumbnail texture %s"), *LeastRecentlyUsed.ToString());
+	}
+}
+
+FThumbnailLoadResult UThumbnailExporterSubsystem::MakeLoadResult(const FThumbnailManifestEntry& Entry, UTexture2D* Texture)
+{
+	FThumbnailLoadResult Result;
+	Result.bSuccess = Texture != nullptr;
+	Result.Texture = Texture;
+	Result.UVOffset = Entry.UVOffset;
+	Result.UVSize = Entry.UVSize;
+	Result.NumFrames = Entry.NumFrames;
+	Result.NumFrameColumns = Entry.NumFrameColumns;
+	return Result;
+}
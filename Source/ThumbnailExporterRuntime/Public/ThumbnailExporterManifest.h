@@ -0,0 +1,57 @@
+// Copyright 2023 Big Cat Energising. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "Engine/Texture2D.h"
+#include "ThumbnailExporterManifest.generated.h"
+
+USTRUCT(BlueprintType)
+struct THUMBNAILEXPORTERRUNTIME_API FThumbnailManifestEntry
+{
+	GENERATED_USTRUCT_BODY()
+
+	// The texture containing the asset's thumbnail. Assets with identical thumbnails share the same texture
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Thumbnail Manifest")
+		TSoftObjectPtr<UTexture2D> Texture;
+
+	// Index of the atlas page in the manifest's AtlasPages, or INDEX_NONE if the thumbnail has its own texture
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Thumbnail Manifest")
+		int32 AtlasPage = INDEX_NONE;
+
+	// UV rect of the thumbnail inside Texture
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Thumbnail Manifest")
+		FVector2D UVOffset = FVector2D::ZeroVector;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Thumbnail Manifest")
+		FVector2D UVSize = FVector2D::UnitVector;
+
+	// Number of frames in the thumbnail's sprite sheet, laid out left to right then top to bottom inside the UV rect
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Thumbnail Manifest")
+		int32 NumFrames = 1;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Thumbnail Manifest")
+		int32 NumFrameColumns = 1;
+};
+
+/**
+ * Maps exported assets to the texture their thumbnail was written to, and where in the texture it is.
+ * Written by batch exports that don't give every asset its own texture (deduplicated and atlased exports)
+ */
+UCLASS(BlueprintType)
+class THUMBNAILEXPORTERRUNTIME_API UThumbnailExporterManifest : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Thumbnail Manifest")
+		TMap<FSoftObjectPath, FThumbnailManifestEntry> Thumbnails;
+
+	// Atlas pages written by the last atlased export to this manifest
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Thumbnail Manifest")
+		TArray<TSoftObjectPtr<UTexture2D>> AtlasPages;
+
+	// Returns the thumbnail entry for the asset, or nullptr if the asset isn't in the manifest
+	const FThumbnailManifestEntry* FindThumbnail(const FSoftObjectPath& Asset) const { return Thumbnails.Find(Asset); }
+};
@@ -0,0 +1,58 @@
+// Copyright 2023 Big Cat Energising. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "ThumbnailExporterNaming.generated.h"
+
+// How the texture of an exported thumbnail is named after its asset
+USTRUCT(BlueprintType)
+struct THUMBNAILEXPORTERRUNTIME_API FThumbnailNamingRules
+{
+	GENERATED_USTRUCT_BODY()
+
+	// If true, then the thumbnail is not in the same folder as the asset, but in ThumbnailOverridePath
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Filename")
+		bool bOverrideThumbnailPath = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Filename", meta = (EditCondition = "bOverrideThumbnailPath", ContentDir))
+		FDirectoryPath ThumbnailOverridePath;
+
+	// Added before the asset name in the thumbnail filename
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Filename")
+		FString ThumbnailPrefix = "T_";
+
+	// Added after the asset name in the thumbnail filename
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnail|Filename")
+		FString ThumbnailSuffix = "_Icon";
+
+	// True if both rules name thumbnails the same way. The override path only matters when it is used
+	bool operator==(const FThumbnailNamingRules& Other) const
+	{
+		return bOverrideThumbnailPath == Other.bOverrideThumbnailPath
+			&& (!bOverrideThumbnailPath || ThumbnailOverridePath.Path == Other.ThumbnailOverridePath.Path)
+			&& ThumbnailPrefix == Other.ThumbnailPrefix
+			&& ThumbnailSuffix == Other.ThumbnailSuffix;
+	}
+
+	bool operator!=(const FThumbnailNamingRules& Other) const
+	{
+		return !(*this == Other);
+	}
+};
+
+/**
+ * Naming functions shared by the exporter, which writes thumbnails, and the runtime, which looks them up.
+ * The rules themselves are set twice, on the export presets and in the runtime settings, the editor warns when they don't match
+ */
+class THUMBNAILEXPORTERRUNTIME_API FThumbnailExporterNaming
+{
+public:
+	// Returns the package name of the asset's thumbnail texture, e.g. /Game/Props/T_Chair_Icon for /Game/Props/Chair.Chair.
+	// OverrideFilename replaces Prefix + AssetName + Suffix when set. Only needs the asset's path, the asset doesn't have to be loaded
+	static FString GetThumbnailPackageName(const FThumbnailNamingRules& Rules, const FString& AssetObjectPath, const TOptional<FString>& OverrideFilename = {});
+
+	// Returns the object path of the asset's thumbnail texture, e.g. /Game/Props/T_Chair_Icon.T_Chair_Icon
+	static FSoftObjectPath GetThumbnailTexturePath(const FThumbnailNamingRules& Rules, const FSoftObjectPath& Asset);
+};
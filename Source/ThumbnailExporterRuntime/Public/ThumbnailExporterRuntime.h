@@ -0,0 +1,15 @@
+// Copyright 2023 Big Cat Energising. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Modules/ModuleManager.h"
+
+THUMBNAILEXPORTERRUNTIME_API DECLARE_LOG_CATEGORY_EXTERN(LogThumbnailExporterRuntime, Log, All);
+
+/**
+ * Runtime side of the thumbnail exporter: what games need to find and load exported thumbnails
+ */
+class FThumbnailExporterRuntimeModule : public IModuleInterface
+{
+};
@@ -0,0 +1,33 @@
+// Copyright 2023 Big Cat Energising. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DeveloperSettings.h"
+#include "ThumbnailExporterNaming.h"
+#include "ThumbnailExporterRuntimeSettings.generated.h"
+
+/**
+ * Where the game finds exported thumbnails, and how many it keeps loaded
+ */
+UCLASS(config = Game, defaultconfig, DisplayName = "Thumbnail Exporter Runtime")
+class THUMBNAILEXPORTERRUNTIME_API UThumbnailExporterRuntimeSettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+
+public:
+	// Naming rules of the export preset the thumbnails were exported with. These are a copy of the preset's filename settings,
+	// the editor logs a warning when they match none of the presets
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnails", meta = (ShowOnlyInnerProperties))
+		FThumbnailNamingRules NamingRules;
+
+	// Manifest written by deduplicated or atlased exports. Assets in the manifest use its texture and UV rect instead of the naming rules
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Thumbnails")
+		TSoftObjectPtr<class UThumbnailExporterManifest> Manifest;
+
+	// Texture memory the thumbnail cache keeps loaded, in megabytes. Past it, the least recently used thumbnail textures are released
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Cache", meta = (ClampMin = 0, UIMin = 0, UIMax = 1024))
+		float TextureMemoryBudgetMB = 64.f;
+
+	static UThumbnailExporterRuntimeSettings* Get() { return GetMutableDefault<UThumbnailExporterRuntimeSettings>(); }
+};
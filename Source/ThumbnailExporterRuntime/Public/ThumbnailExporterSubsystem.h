@@ -0,0 +1,149 @@
+// Copyright 2023 Big Cat Energising. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Engine/StreamableManager.h"
+#include "ThumbnailExporterManifest.h"
+#include "ThumbnailExporterSubsystem.generated.h"
+
+USTRUCT(BlueprintType)
+struct THUMBNAILEXPORTERRUNTIME_API FThumbnailLoadResult
+{
+	GENERATED_USTRUCT_BODY()
+
+	// False if the asset has no exported thumbnail, or its texture couldn't be loaded
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		bool bSuccess = false;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		UTexture2D* Texture = nullptr;
+
+	// UV rect of the thumbnail inside Texture, for atlased thumbnails
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		FVector2D UVOffset = FVector2D::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		FVector2D UVSize = FVector2D::UnitVector;
+
+	// Sprite sheet layout of the thumbnail. Only known for thumbnails in the manifest, others are treated as a single frame
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		int32 NumFrames = 1;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		int32 NumFrameColumns = 1;
+};
+
+USTRUCT(BlueprintType)
+struct THUMBNAILEXPORTERRUNTIME_API FThumbnailCacheStats
+{
+	GENERATED_USTRUCT_BODY()
+
+	// Requests for textures that were already loaded or loading
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		int32 NumHits = 0;
+
+	// Requests that started a texture load
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		int32 NumMisses = 0;
+
+	// Textures released to stay within the memory budget
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		int32 NumEvictions = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		int32 NumCachedTextures = 0;
+
+	// Memory of the loaded textures in the cache, with all of their mips, in bytes
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		int64 CachedBytes = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Thumbnail Exporter")
+		int64 BudgetBytes = 0;
+};
+
+DECLARE_DELEGATE_OneParam(FOnThumbnailLoaded, const FThumbnailLoadResult& /*Result*/);
+DECLARE_DYNAMIC_DELEGATE_OneParam(FOnThumbnailLoadedDynamic, const FThumbnailLoadResult&, Result);
+
+/**
+ * Finds and loads the exported thumbnails of assets. Thumbnail textures are loaded asynchronously and kept in a
+ * least recently used cache, bounded by the texture memory budget in the runtime settings
+ */
+UCLASS()
+class THUMBNAILEXPORTERRUNTIME_API UThumbnailExporterSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem implementation
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// Loads the asset's thumbnail, then calls OnLoaded. Thumbnails that are already loaded call OnLoaded straight away
+	void RequestThumbnail(const FSoftObjectPath& Asset, FOnThumbnailLoaded OnLoaded);
+
+	UFUNCTION(BlueprintCallable, Category = "Thumbnail Exporter", meta = (DisplayName = "Request Thumbnail"))
+		void K2_RequestThumbnail(TSoftObjectPtr<UObject> Asset, FOnThumbnailLoadedDynamic OnLoaded);
+
+	// Returns true and fills OutResult if the asset's thumbnail is already loaded. Marks it as recently used, but doesn't count as a hit or a miss
+	UFUNCTION(BlueprintCallable, Category = "Thumbnail Exporter")
+		bool FindThumbnail(TSoftObjectPtr<UObject> Asset, FThumbnailLoadResult& OutResult);
+
+	// Returns where the asset's thumbnail is: its manifest entry, or the texture the naming rules give when the asset isn't in the manifest
+	FThumbnailManifestEntry ResolveThumbnail(const FSoftObjectPath& Asset) const;
+
+	UFUNCTION(BlueprintCallable, Category = "Thumbnail Exporter")
+		void SetTextureMemoryBudget(float BudgetMB);
+
+	UFUNCTION(BlueprintPure, Category = "Thumbnail Exporter")
+		FThumbnailCacheStats GetCacheStats() const;
+
+	// Releases every cached texture. Loads in flight still complete
+	UFUNCTION(BlueprintCallable, Category = "Thumbnail Exporter")
+		void ClearCache();
+
+protected:
+	struct FPendingRequest
+	{
+		FThumbnailManifestEntry Entry;
+		FOnThumbnailLoaded OnLoaded;
+	};
+
+	// A thumbnail texture, shared by every asset that uses it
+	struct FCachedTexture
+	{
+		// Keeps the texture loaded
+		TSharedPtr<FStreamableHandle> Handle;
+		TWeakObjectPtr<UTexture2D> Texture;
+
+		// Requests waiting for the texture to load
+		TArray<FPendingRequest> PendingRequests;
+
+		bool bLoaded = false;
+		int64 Bytes = 0;
+		uint64 LastUsed = 0;
+	};
+
+	void OnTextureLoaded(FSoftObjectPath TexturePath);
+
+	// Releases the least recently used textures until the cache is within the budget. KeepTexturePath is never released
+	void EvictToBudget(const FSoftObjectPath& KeepTexturePath);
+
+	static FThumbnailLoadResult MakeLoadResult(const FThumbnailManifestEntry& Entry, UTexture2D* Texture);
+
+	UPROPERTY()
+		UThumbnailExporterManifest* Manifest = nullptr;
+
+	FThumbnailNamingRules NamingRules;
+
+	FStreamableManager StreamableManager;
+
+	// Texture path -> cached texture
+	TMap<FSoftObjectPath, FCachedTexture> CachedTextures;
+
+	// Incremented on every use, so the texture with the lowest LastUsed is the least recently used one
+	uint64 UseCounter = 0;
+
+	FThumbnailCacheStats Stats;
+};
@@ -0,0 +1,21 @@
+// Copyright 2023 Big Cat Energising. All Rights Reserved.
+
+using UnrealBuildTool;
+
+public class ThumbnailExporterRuntime : ModuleRules
+{
+	public ThumbnailExporterRuntime(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PublicDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"Core",
+				"CoreUObject",
+				"Engine",
+				"DeveloperSettings"
+			}
+		);
+	}
+}